@@ -0,0 +1,53 @@
+#!/bin/sh
+# Usage: check-multiarch.sh <level> <object>
+#
+# Checks one partially linked level of the multi-arch build. Its entry point must be the only symbol it defines
+# globally, as the linker could otherwise resolve another level's references to it. The level is then disassembled and
+# must not contain instructions above it, which would crash with SIGILL on the machines the level exists for. avx512 is
+# not disassembled, as it is the highest level.
+
+set -eu
+
+level=$1
+object=$2
+objdump=${OBJDUMP:-objdump}
+nm=${NM:-nm}
+tab=$(printf '\t')
+
+symbols=$("$nm" -g --defined-only "$object")
+exported=$(echo "$symbols" | awk 'NF >= 3 { print $3 }' | grep -v "^_ZN[0-9]*rose_${level}5entryEiPPc\$" || true)
+if [ -n "$exported" ]; then
+  echo "check-multiarch.sh: $object defines symbols other than its entry point globally:" >&2
+  echo "$exported" | head -n 20 >&2
+  exit 1
+fi
+
+case $level in
+  sse4_2)
+    # Any VEX or EVEX encoded instruction (the mnemonic starts with v or an {evex}-style pseudo-prefix), BMI1, BMI2,
+    # LZCNT, MOVBE and GFNI. TZCNT is allowed: compilers emit it for ctz at any level, as it runs as BSF on older CPUs.
+    pattern="${tab}(\\{|v)|${tab}(andn|bextr|blsi|blsmsk|blsr|bzhi|lzcnt|movbe|mulx|pdep|pext|rorx|sarx|shlx|shrx|gf2p8[a-z]*)( |\$)"
+    ;;
+  avx2)
+    # EVEX encoded instructions all start with the byte 62 in 64-bit mode. GFNI and VNNI also have VEX encodings.
+    pattern="^62 |${tab}(\\{vex\\} )?(v?gf2p8|vpdpbusd|vpdpwssd)"
+    ;;
+  avx512)
+    exit 0
+    ;;
+  *)
+    echo "check-multiarch.sh: unknown level $level" >&2
+    exit 2
+    ;;
+esac
+
+# Each line of the listing is "<bytes><tab><mnemonic> <operands>".
+disassembly=$("$objdump" -d "$object")
+listing=$(echo "$disassembly" | awk -F'\t' 'NF >= 3 { print $2 "\t" $3 }')
+found=$(echo "$listing" | grep -E "$pattern" | cut -f2 | awk '{ print $1 }' || true)
+
+if [ -n "$found" ]; then
+  echo "check-multiarch.sh: $object contains instructions above $level:" >&2
+  echo "$found" | sort | uniq -c | sort -rn | head -n 20 >&2
+  exit 1
+fi
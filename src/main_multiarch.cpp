@@ -0,0 +1,29 @@
+// Entry point of the multi-arch build (`make multiarch`). The library is compiled once per instruction set, each copy in
+// its own namespace (rose_<level>), and the best copy the CPU supports is chosen here at startup.
+
+namespace rose_avx512 {
+  auto entry(int argc, char** argv) -> int;
+}
+
+namespace rose_avx2 {
+  auto entry(int argc, char** argv) -> int;
+}
+
+namespace rose_sse4_2 {
+  auto entry(int argc, char** argv) -> int;
+}
+
+static auto supports_avx512() -> bool {
+  return __builtin_cpu_supports("x86-64-v4") && __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512vbmi")
+      && __builtin_cpu_supports("avx512vbmi2") && __builtin_cpu_supports("gfni");
+}
+
+auto main(int argc, char** argv) -> int {
+  __builtin_cpu_init();
+
+  if (supports_avx512())
+    return rose_avx512::entry(argc, argv);
+  if (__builtin_cpu_supports("x86-64-v3"))
+    return rose_avx2::entry(argc, argv);
+  return rose_sse4_2::entry(argc, argv);
+}
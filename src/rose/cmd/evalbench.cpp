@@ -0,0 +1,176 @@
+#include "rose/cmd/evalbench.hpp"
+
+#include "rose/cmd/bench.hpp"
+#include "rose/common.hpp"
+#include "rose/eval/nnue/arch.hpp"
+#include "rose/move.hpp"
+#include "rose/movegen.hpp"
+#include "rose/position.hpp"
+#include "rose/util/time.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fmt/format.h>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace rose::evalbench {
+
+  using namespace eval::nnue;
+
+  static constexpr usize playout_length = 16;
+  static constexpr usize evaluate_repetitions = 32;
+  static constexpr time::Milliseconds min_measure_time {250};
+
+  // A bench position followed by a fixed sequence of random legal moves.
+  struct Playout {
+    Position root;
+    std::vector<Move> moves;
+  };
+
+  // Keeps the compiler from discarding work whose result is otherwise unused.
+  template<typename T>
+  static auto keep(const T& value) -> void {
+    asm volatile("" : : "m"(value) : "memory");
+  }
+
+  static auto nanoseconds(time::Duration d) -> f64 {
+    return time::cast<std::chrono::duration<f64, std::nano>>(d).count();
+  }
+
+  static auto make_playouts() -> std::vector<Playout> {
+    std::mt19937_64 prng {87};
+
+    std::vector<Playout> playouts;
+    for (const std::string_view fen : bench::bench_fens) {
+      Playout playout {Position::parse(fen).value(), {}};
+      Position pos = playout.root;
+      for (usize ply = 0; ply < playout_length; ply++) {
+        const MoveList moves = generate_all_moves(pos);
+        if (moves.size() == 0)
+          break;
+        const Move m = moves[std::uniform_int_distribution<usize> {0, moves.size() - 1}(prng)];
+        playout.moves.push_back(m);
+        pos = pos.move(m);
+      }
+      playouts.push_back(std::move(playout));
+    }
+    return playouts;
+  }
+
+  // Only the feature transformer is randomised, so that the activations seen by the later layers are neither all zero
+  // nor all saturated. The remaining weights are zero; the cost of the dense layers does not depend on their values.
+  template<typename Arch>
+  static auto random_network() -> std::unique_ptr<typename Arch::Network> {
+    std::mt19937_64 prng {87};
+    std::uniform_int_distribution<int> weight {-32, 32};
+    std::uniform_int_distribution<int> bias {-64, 128};
+
+    auto net = std::make_unique<typename Arch::Network>();
+    for (auto& row : net->accumulator_weights)
+      for (auto& w : row)
+        w = static_cast<std::remove_reference_t<decltype(w)>>(weight(prng));
+    for (auto& b : net->accumulator_biases)
+      b = static_cast<i16>(bias(prng));
+    return net;
+  }
+
+  template<typename Arch>
+  static auto run_arch(std::string_view name, const std::vector<Playout>& playouts) -> void {
+    const auto net = random_network<Arch>();
+    const auto state = std::make_unique<typename Arch::State>(*net);
+
+    std::vector<Position> positions;
+    for (const Playout& playout : playouts) {
+      Position pos = playout.root;
+      positions.push_back(pos);
+      for (const Move m : playout.moves) {
+        pos = pos.move(m);
+        positions.push_back(pos);
+      }
+    }
+
+    // Full accumulator rebuilds.
+    usize rebuild_count = 0;
+    const time::TimePoint rebuild_start = time::Clock::now();
+    time::Duration rebuild_time {};
+    while (rebuild_time < min_measure_time) {
+      for (const Position& pos : positions)
+        state->reset(pos);
+      rebuild_count += positions.size();
+      rebuild_time = time::Clock::now() - rebuild_start;
+    }
+
+    // Incremental updates, replayed along the playouts. The same moves are also made without an observer, and that time
+    // is subtracted so that only the cost of the updates remains.
+    usize update_count = 0;
+    time::Duration observed_time {};
+    time::Duration unobserved_time {};
+    while (observed_time < min_measure_time) {
+      for (const Playout& playout : playouts) {
+        state->reset(playout.root);
+
+        const time::TimePoint observed_start = time::Clock::now();
+        Position pos = playout.root;
+        for (const Move m : playout.moves) {
+          state->push();
+          pos = pos.move(m, state->observer());
+        }
+        keep(pos);
+        observed_time += time::Clock::now() - observed_start;
+
+        for (usize i = 0; i < playout.moves.size(); i++)
+          state->pop();
+
+        const time::TimePoint unobserved_start = time::Clock::now();
+        pos = playout.root;
+        for (const Move m : playout.moves)
+          pos = pos.move(m);
+        keep(pos);
+        unobserved_time += time::Clock::now() - unobserved_start;
+
+        update_count += playout.moves.size();
+      }
+    }
+
+    // Evaluation from an up-to-date accumulator.
+    usize evaluate_count = 0;
+    time::Duration evaluate_time {};
+    while (evaluate_time < min_measure_time) {
+      for (const Position& pos : positions) {
+        state->reset(pos);
+
+        const time::TimePoint evaluate_start = time::Clock::now();
+        for (usize i = 0; i < evaluate_repetitions; i++) {
+          const Score score = state->evaluate(pos);
+          keep(score);
+        }
+        evaluate_time += time::Clock::now() - evaluate_start;
+      }
+      evaluate_count += positions.size() * evaluate_repetitions;
+    }
+
+    const f64 rebuild_ns = nanoseconds(rebuild_time) / static_cast<f64>(rebuild_count);
+    const f64 update_ns = std::max(nanoseconds(observed_time - unobserved_time), 0.0) / static_cast<f64>(update_count);
+    const f64 evaluate_ns = nanoseconds(evaluate_time) / static_cast<f64>(evaluate_count);
+
+    fmt::print("{:<16} {:>10.1f} {:>10.1f} {:>14.0f} {:>10.1f}\n", name, rebuild_ns, update_ns, 1e9 / update_ns, evaluate_ns);
+    std::fflush(stdout);
+  }
+
+  auto run() -> void {
+    const std::vector<Playout> playouts = make_playouts();
+
+    fmt::print("{:<16} {:>10} {:>10} {:>14} {:>10}\n", "arch", "rebuild", "update", "updates/s", "evaluate");
+    fmt::print("{:<16} {:>10} {:>10} {:>14} {:>10}\n", "", "ns/op", "ns/op", "", "ns/op");
+
+#define rose_evalbench_arch(name, T) run_arch<T>(#name, playouts);
+    rose_for_each_arch(rose_evalbench_arch)
+#undef rose_evalbench_arch
+  }
+
+}  // namespace rose::evalbench
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace rose::evalbench {
+
+  auto run() -> void;
+
+}  // namespace rose::evalbench
@@ -1,27 +1,77 @@
 #include "rose/cmd/perft.hpp"
 
 #include "rose/common.hpp"
+#include "rose/hash.hpp"
 #include "rose/move.hpp"
 #include "rose/movegen.hpp"
 #include "rose/position.hpp"
 #include "rose/util/time.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <fmt/format.h>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
 
 namespace rose::perft {
 
+  // Lock-free table of subtree counts. Each slot holds its data (count and depth) and the position hash xored with that
+  // data. A slot torn by two threads storing at once fails the check on load rather than returning a wrong count.
+  class HashTable {
+  private:
+    static constexpr usize depth_width = 8;
+    static constexpr u64 depth_mask = (u64 {1} << depth_width) - 1;
+
+    struct Slot {
+      std::atomic<u64> check;
+      std::atomic<u64> data;
+    };
+
+    usize m_count;
+    std::unique_ptr<Slot[]> m_slots;
+
+    auto slot(Hash hash) const -> Slot& {
+      return m_slots[static_cast<usize>((static_cast<u128>(hash) * m_count) >> 64)];
+    }
+
+  public:
+    explicit HashTable(usize mb) :
+        m_count {std::max<usize>(mb * 1024 * 1024 / sizeof(Slot), 1)},
+        m_slots {std::make_unique<Slot[]>(m_count)} {}
+
+    auto load(Hash hash, usize depth) const -> std::optional<u64> {
+      const Slot& s = slot(hash);
+      const u64 data = s.data.load(std::memory_order_relaxed);
+      const u64 check = s.check.load(std::memory_order_relaxed);
+      if ((check ^ data) != hash || (data & depth_mask) != depth)
+        return std::nullopt;
+      return data >> depth_width;
+    }
+
+    auto store(Hash hash, usize depth, u64 count) -> void {
+      Slot& s = slot(hash);
+      const u64 data = (count << depth_width) | depth;
+      s.check.store(hash ^ data, std::memory_order_relaxed);
+      s.data.store(data, std::memory_order_relaxed);
+    }
+  };
+
   template<bool print, bool bulk>
   static auto core(const Position& position, usize depth) -> u64 {
     if (depth == 0)
       return 1;
 
+    if (!print && depth == 1 && bulk)
+      return count_legal_moves(position);
+
     u64 result = 0;
 
     const MoveList moves = generate_all_moves(position);
 
-    if (!print && depth == 1 && bulk)
-      return moves.size();
-
     for (Move m : moves) {
       const Position new_position = position.move(m);
       rose_assert(new_position.calc_hashes_slow() == position.hashes_after(position.calc_hashes_slow(), m));
@@ -36,13 +86,145 @@ namespace rose::perft {
     return result;
   }
 
-  auto value(const Position& position, usize depth) -> u64 {
-    return core<false, true>(position, depth);
+  // As core, but reuses the counts of transposed subtrees. Depth 1 nodes are cheaper to count than to look up.
+  template<bool bulk>
+  static auto core_hashed(HashTable& table, const Position& position, Hashes hashes, usize depth) -> u64 {
+    if (depth == 0)
+      return 1;
+
+    if (depth >= 2) {
+      if (const std::optional<u64> count = table.load(hashes.full(), depth))
+        return *count;
+    }
+
+    if (depth == 1 && bulk)
+      return count_legal_moves(position);
+
+    const MoveList moves = generate_all_moves(position);
+
+    u64 result = 0;
+    for (Move m : moves) {
+      Hashes new_hashes = hashes;
+      const Position new_position = position.move(m, new_hashes);
+      rose_assert(new_position.calc_hashes_slow() == new_hashes);
+      result += core_hashed<bulk>(table, new_position, new_hashes, depth - 1);
+    }
+
+    if (depth >= 2)
+      table.store(hashes.full(), depth, result);
+
+    return result;
+  }
+
+  struct Task {
+    usize root_index;
+    Position position;
+    Hashes hashes;
+    usize depth;
+  };
+
+  struct RootMove {
+    Move move;
+    std::atomic<u64> nodes = 0;
+    std::atomic<usize> remaining = 0;
+  };
+
+  // Splits the tree two plies below the root (one ply for shallow perfts), so that there are enough tasks to keep every
+  // thread busy even when a few root moves dominate the node count.
+  static auto make_tasks(const Position& position, usize depth, const MoveList& moves, std::span<RootMove> root_moves) -> std::vector<Task> {
+    const Hashes hashes = position.calc_hashes_slow();
+
+    std::vector<Task> tasks;
+    for (usize i = 0; i < moves.size(); i++) {
+      Hashes child_hashes = hashes;
+      const Position child = position.move(moves[i], child_hashes);
+
+      if (depth < 3) {
+        tasks.push_back({i, child, child_hashes, depth - 1});
+        continue;
+      }
+
+      for (Move m : generate_all_moves(child)) {
+        Hashes grandchild_hashes = child_hashes;
+        const Position grandchild = child.move(m, grandchild_hashes);
+        tasks.push_back({i, grandchild, grandchild_hashes, depth - 2});
+      }
+    }
+
+    for (const Task& task : tasks)
+      root_moves[task.root_index].remaining.fetch_add(1, std::memory_order_relaxed);
+
+    return tasks;
+  }
+
+  template<bool bulk>
+  static auto worker(const std::vector<Task>& tasks, std::atomic<usize>& next, std::span<RootMove> root_moves, HashTable* table) -> void {
+    for (usize i = next.fetch_add(1, std::memory_order_relaxed); i < tasks.size(); i = next.fetch_add(1, std::memory_order_relaxed)) {
+      const Task& task = tasks[i];
+      const u64 nodes = table ? core_hashed<bulk>(*table, task.position, task.hashes, task.depth) : core<false, bulk>(task.position, task.depth);
+
+      RootMove& root_move = root_moves[task.root_index];
+      root_move.nodes.fetch_add(nodes, std::memory_order_relaxed);
+      if (root_move.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        root_move.remaining.notify_all();
+    }
+  }
+
+  // Counts the nodes below each root move on options.threads threads, calling on_root_move for each root move in move
+  // generation order as soon as its subtree is complete.
+  template<typename F>
+  static auto parallel(const Position& position, usize depth, const Options& options, F on_root_move) -> u64 {
+    if (depth == 0)
+      return 1;
+
+    const MoveList moves = generate_all_moves(position);
+    const auto root_moves = std::make_unique<RootMove[]>(moves.size());
+    for (usize i = 0; i < moves.size(); i++)
+      root_moves[i].move = moves[i];
+    const std::span<RootMove> root_span {root_moves.get(), moves.size()};
+
+    const std::vector<Task> tasks = make_tasks(position, depth, moves, root_span);
+    const auto table = options.hash_mb > 0 ? std::make_unique<HashTable>(options.hash_mb) : nullptr;
+
+    std::atomic<usize> next = 0;
+    std::vector<std::jthread> threads;
+    for (usize t = 0; t < std::max<usize>(options.threads, 1); t++) {
+      if (options.bulk)
+        threads.emplace_back(&worker<true>, std::cref(tasks), std::ref(next), root_span, table.get());
+      else
+        threads.emplace_back(&worker<false>, std::cref(tasks), std::ref(next), root_span, table.get());
+    }
+
+    u64 total = 0;
+    for (RootMove& root_move : root_span) {
+      for (usize r = root_move.remaining.load(std::memory_order_acquire); r != 0; r = root_move.remaining.load(std::memory_order_acquire))
+        root_move.remaining.wait(r, std::memory_order_acquire);
+
+      const u64 nodes = root_move.nodes.load(std::memory_order_relaxed);
+      on_root_move(root_move.move, nodes);
+      total += nodes;
+    }
+
+    return total;
   }
 
-  auto run(const Position& position, usize depth, bool bulk) -> void {
+  auto value(const Position& position, usize depth, const Options& options) -> u64 {
+    if (options.threads <= 1 && options.hash_mb == 0)
+      return options.bulk ? core<false, true>(position, depth) : core<false, false>(position, depth);
+    return parallel(position, depth, options, [](Move, u64) {});
+  }
+
+  auto run(const Position& position, usize depth, const Options& options) -> void {
     const auto start = time::Clock::now();
-    const u64 total = bulk ? core<true, true>(position, depth) : core<true, false>(position, depth);
+    u64 total;
+    if (options.threads <= 1 && options.hash_mb == 0) {
+      total = options.bulk ? core<true, true>(position, depth) : core<true, false>(position, depth);
+    } else {
+      total = parallel(position, depth, options, [](Move m, u64 nodes) {
+        fmt::print("{}: {}\n", m.to_string(MoveFormat::frc), nodes);
+        std::fflush(stdout);
+      });
+    }
     const auto end = time::Clock::now();
 
     const time::FloatSeconds elapsed = end - start;
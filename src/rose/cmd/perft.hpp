@@ -5,7 +5,14 @@
 
 namespace rose::perft {
 
-  auto value(const Position& position, usize depth) -> u64;
-  auto run(const Position& position, usize depth, bool bulk) -> void;
+  struct Options {
+    bool bulk = true;
+    usize threads = 1;
+    // Size of the perft hash table in MiB; 0 disables it.
+    usize hash_mb = 0;
+  };
+
+  auto value(const Position& position, usize depth, const Options& options = {}) -> u64;
+  auto run(const Position& position, usize depth, const Options& options) -> void;
 
 }  // namespace rose::perft
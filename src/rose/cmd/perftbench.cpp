@@ -0,0 +1,67 @@
+#include "rose/cmd/perftbench.hpp"
+
+#include "rose/cmd/perft.hpp"
+#include "rose/common.hpp"
+#include "rose/position.hpp"
+#include "rose/util/time.hpp"
+
+#include <array>
+#include <cstdio>
+#include <fmt/format.h>
+#include <string_view>
+
+namespace rose::perftbench {
+
+  struct Case {
+    std::string_view name;
+    std::string_view fen;
+    usize depth;
+    u64 nodes;
+  };
+
+  static constexpr std::array<Case, 10> cases {{
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, 119060324},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690},
+    {"enpassant", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7, 178633661},
+    {"promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292},
+    {"promotions-b", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, 15833292},
+    {"underpromo", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194},
+    {"middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, 164075551},
+    {"frc-1", "bqnb1rkr/pp3ppp/3ppn2/2p5/5P2/P2P4/NPP1P1PP/BQ1BNRKR w HFhf - 2 9", 5, 8146062},
+    {"frc-2", "1bbrnkqr/pp1p1ppp/2p1p3/1n6/5P2/3Q4/PPPPP1PP/NBBRNK1R w HDhd - 2 9", 5, 26998966},
+    {"dfrc-castling", "2r1kr2/8/8/8/8/8/8/1R2K1R1 w GBfc - 0 1", 6, 149271720},
+  }};
+
+  auto run() -> void {
+    fmt::print("{:<16} {:>5} {:>12} {:>10} {:>8}\n", "position", "depth", "nodes", "ms", "Mnps");
+
+    u64 total_nodes = 0;
+    time::FloatSeconds total_elapsed {0};
+    usize failures = 0;
+
+    for (const Case& c : cases) {
+      const Position position = Position::parse(c.fen).value();
+
+      const auto start = time::Clock::now();
+      const u64 nodes = perft::value(position, c.depth);
+      const time::FloatSeconds elapsed = time::Clock::now() - start;
+
+      total_nodes += nodes;
+      total_elapsed += elapsed;
+
+      fmt::print("{:<16} {:>5} {:>12} {:>10.1f} {:>8.1f}", c.name, c.depth, nodes, elapsed.count() * 1000, time::nps<f64>(nodes, elapsed) / 1'000'000);
+      if (nodes != c.nodes) {
+        fmt::print(" MISMATCH (expected {})", c.nodes);
+        failures++;
+      }
+      fmt::print("\n");
+      std::fflush(stdout);
+    }
+
+    fmt::print("Perftbench: {} nodes {:.1f} Mnps", total_nodes, time::nps<f64>(total_nodes, total_elapsed) / 1'000'000);
+    if (failures > 0)
+      fmt::print(" ({} of {} positions MISMATCHED)", failures, cases.size());
+    fmt::print("\n");
+  }
+
+}  // namespace rose::perftbench
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace rose::perftbench {
+
+  auto run() -> void;
+
+}  // namespace rose::perftbench
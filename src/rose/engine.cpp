@@ -3,18 +3,20 @@
 #include "rose/common.hpp"
 #include "rose/engine_output.hpp"
 #include "rose/engine_output_null.hpp"
-#include "rose/eval/nnue/embedded.hpp"
+#include "rose/eval/nnue/network.hpp"
 #include "rose/game.hpp"
 #include "rose/search.hpp"
 #include "rose/tt.hpp"
 #include "rose/util/assert.hpp"
 
 #include <memory>
+#include <utility>
 
 namespace rose {
 
   Engine::Engine() :
       m_output(std::make_shared<EngineOutputNull>()),
+      m_network(eval::nnue::LoadedNetwork::embedded()),
       m_tt_size(tt::default_hash_size_mb) {
     set_thread_count(1);
   }
@@ -50,8 +52,11 @@ namespace rose {
 
     m_shared = std::make_unique<SearchShared>(thread_count, m_tt_size, m_output);
 
-    for (int i = 0; i < thread_count; i++)
-      m_searches.emplace_back(std::make_unique<Search<eval::nnue::EmbeddedArch::State>>(i, *m_shared, eval::nnue::embedded_network()));
+    for (int i = 0; i < thread_count; i++) {
+      m_searches.emplace_back(m_network.visit([&]<typename Arch>(const Arch::Network& network) -> std::unique_ptr<SearchBase> {
+        return std::make_unique<Search<typename Arch::State>>(i, *m_shared, network);
+      }));
+    }
     for (const auto& search : m_searches)
       search->launch();
   }
@@ -62,6 +67,17 @@ namespace rose {
     m_shared->set_output(output);
   }
 
+  auto Engine::set_network(eval::nnue::LoadedNetwork network) -> void {
+    wait();
+    // Keep the previous network mapped until the searches referencing it have been torn down.
+    const eval::nnue::LoadedNetwork previous = std::exchange(m_network, std::move(network));
+    set_thread_count(static_cast<int>(m_searches.size()));
+  }
+
+  auto Engine::eval_cache_stats() const -> std::tuple<u64, u64> {
+    return {m_shared->total_eval_cache_probes(), m_shared->total_eval_cache_hits()};
+  }
+
   auto Engine::run_search(time::TimePoint start_time, const SearchLimit& limits, const Game& g) -> void {
     m_shared->send_go(start_time, limits, g);
   }
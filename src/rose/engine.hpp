@@ -1,9 +1,11 @@
 #pragma once
 
 #include "rose/common.hpp"
+#include "rose/eval/nnue/network.hpp"
 #include "rose/util/time.hpp"
 
 #include <memory>
+#include <tuple>
 #include <vector>
 
 namespace rose {
@@ -19,6 +21,7 @@ namespace rose {
     std::vector<std::unique_ptr<SearchBase>> m_searches;
     std::unique_ptr<SearchShared> m_shared;
     std::shared_ptr<EngineOutput> m_output;
+    eval::nnue::LoadedNetwork m_network;
     usize m_tt_size;
 
   public:
@@ -30,6 +33,14 @@ namespace rose {
     auto set_hash_size(int mb) -> void;
     auto set_thread_count(int thread_count) -> void;
     auto set_output(std::shared_ptr<EngineOutput> output) -> void;
+    auto set_network(eval::nnue::LoadedNetwork network) -> void;
+
+    auto network() const -> const eval::nnue::LoadedNetwork& {
+      return m_network;
+    }
+
+    // Returns {probes, hits} of the per-thread eval caches during the last search.
+    auto eval_cache_stats() const -> std::tuple<u64, u64>;
 
     auto run_search(time::TimePoint start_time, const SearchLimit& limits, const Game& g) -> void;
 
@@ -0,0 +1,34 @@
+#include "rose/entry.hpp"
+
+#include "rose/common.hpp"
+#include "rose/interface.hpp"
+#include "rose/version.hpp"
+
+#include <fmt/format.h>
+#include <iostream>
+#include <ranges>
+#include <string>
+
+namespace rose {
+
+  auto entry(int argc, char** argv) -> int {
+    fmt::print("# 🌹 Rose {}\n", version::to_string());
+
+    Interface engine;
+
+    if (argc > 1) {
+      for (usize i : std::views::iota(1, argc)) {
+        engine.parse_command(argv[i]);
+        engine.parse_command("wait");
+      }
+      return 0;
+    }
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+      engine.parse_command(line);
+    }
+    return 0;
+  }
+
+}  // namespace rose
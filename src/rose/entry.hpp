@@ -0,0 +1,9 @@
+#pragma once
+
+namespace rose {
+
+  // The body of the engine's main function. It lives in the library so that a multi-arch build can compile it once per
+  // instruction set and pick one at startup.
+  auto entry(int argc, char** argv) -> int;
+
+}  // namespace rose
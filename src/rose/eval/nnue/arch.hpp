@@ -1,17 +1,110 @@
 #pragma once
 
+#include "rose/common.hpp"
+#include "rose/eval/nnue/garnet.hpp"
 #include "rose/eval/nnue/jasper.hpp"
 #include "rose/eval/nnue/kyanite.hpp"
 
+#include <array>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
 namespace rose::eval::nnue {
 
+  // Macro arguments cannot contain commas, so architectures with several template arguments are registered through an alias.
+  using Kyanite768i8 = Kyanite<768, i8>;
+  using Kyanite768ob8 = Kyanite<768, i16, 8>;
+  using Garnet768 = Garnet<768, 16, 32>;
+
+  // Four king buckets: the corner files of the back rank, the centre of the back rank, the second rank, and everything else.
+  // clang-format off
+  using KingBuckets4 = KingBuckets<std::array<u8, 32> {{
+    0, 0, 1, 1,
+    2, 2, 2, 2,
+    3, 3, 3, 3,
+    3, 3, 3, 3,
+    3, 3, 3, 3,
+    3, 3, 3, 3,
+    3, 3, 3, 3,
+    3, 3, 3, 3,
+  }}>;
+  // clang-format on
+  using Kyanite768kb4 = Kyanite<768, i16, 1, KingBuckets4>;
+
   // clang-format off
 #define rose_for_each_arch(x)      \
   x(jasper128, Jasper<128>)        \
   x(jasper256, Jasper<256>)        \
   x(kyanite256, Kyanite<256>)      \
   x(kyanite512, Kyanite<512>)      \
-  x(kyanite768, Kyanite<768>)
+  x(kyanite768, Kyanite<768>)      \
+  x(kyanite768i8, Kyanite768i8)    \
+  x(kyanite768ob8, Kyanite768ob8)  \
+  x(kyanite768kb4, Kyanite768kb4)  \
+  x(garnet768, Garnet768)
   // clang-format on
 
+  enum class ArchId : u8 {
+#define rose_arch_id(name, T) name,
+    rose_for_each_arch(rose_arch_id)
+#undef rose_arch_id
+  };
+
+  template<typename T>
+  consteval auto arch_id_of() -> ArchId {
+#define rose_arch_id_match(name, U) if constexpr (std::is_same_v<T, U>) return ArchId::name; else
+    rose_for_each_arch(rose_arch_id_match) {
+      static_assert(sizeof(T) == 0, "architecture is not registered in rose_for_each_arch");
+    }
+#undef rose_arch_id_match
+  }
+
+  constexpr auto arch_name(ArchId arch) -> std::string_view {
+    switch (arch) {
+#define rose_arch_name(name, T)                                                                                                                      \
+  case ArchId::name:                                                                                                                                 \
+    return #name;
+      rose_for_each_arch(rose_arch_name)
+#undef rose_arch_name
+    }
+    std::unreachable();
+  }
+
+  constexpr auto parse_arch_name(std::string_view str) -> std::optional<ArchId> {
+#define rose_arch_parse(name, T)                                                                                                                     \
+  if (str == #name)                                                                                                                                  \
+    return ArchId::name;
+    rose_for_each_arch(rose_arch_parse)
+#undef rose_arch_parse
+    return std::nullopt;
+  }
+
+  // Calls f.template operator()<Arch>() with the concrete architecture named by arch.
+  template<typename F>
+  constexpr auto visit_arch(ArchId arch, F&& f) -> decltype(auto) {
+    switch (arch) {
+#define rose_visit_arch(name, T)                                                                                                                     \
+  case ArchId::name:                                                                                                                                 \
+    return f.template operator()<T>();
+      rose_for_each_arch(rose_visit_arch)
+#undef rose_visit_arch
+    }
+    std::unreachable();
+  }
+
 }  // namespace rose::eval::nnue
+
+template<>
+struct fmt::formatter<rose::eval::nnue::ArchId, char> {
+  template<class ParseContext>
+  constexpr auto parse(ParseContext& ctx) -> ParseContext::iterator {
+    return ctx.begin();
+  }
+
+  template<class FmtContext>
+  auto format(rose::eval::nnue::ArchId arch, FmtContext& ctx) const -> FmtContext::iterator {
+    return fmt::format_to(ctx.out(), "{}", rose::eval::nnue::arch_name(arch));
+  }
+};
@@ -0,0 +1,88 @@
+#include "rose/eval/nnue/batch.hpp"
+
+#include "rose/common.hpp"
+#include "rose/eval/nnue/network.hpp"
+#include "rose/position.hpp"
+#include "rose/score.hpp"
+#include "rose/util/assert.hpp"
+#include "rose/util/static_vector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace rose::eval::nnue {
+
+  // Number of positions whose feature transformers are run together.
+  inline constexpr usize interleave_count = 4;
+
+  // Builds the accumulators of up to interleave_count positions at once. Each step adds one feature to every position in
+  // the group; those updates are independent of each other, so the weight row loads of different positions overlap
+  // instead of each position waiting on its own rows in turn.
+  template<typename Arch>
+  static auto rebuild_accumulators(const typename Arch::Network& net, std::span<const Position> positions, std::span<typename Arch::AccumulatorPair> out)
+    -> void {
+    rose_assert(positions.size() <= interleave_count && positions.size() == out.size());
+
+    std::array<StaticVector<std::array<usize, 2>, 32>, interleave_count> features;
+    usize max_feature_count = 0;
+
+    for (usize k = 0; k < positions.size(); k++) {
+      const Position& pos = positions[k];
+      out[k].values.fill(net.accumulator_biases);
+
+      for (const Square sq : pos.board().occupied_bitboard()) {
+        const Place p = pos.place_at(sq);
+        features[k].push_back({
+          Arch::feature_index(pos, Color::white, sq, p.ptype(), p.color()),
+          Arch::feature_index(pos, Color::black, sq, p.ptype(), p.color()),
+        });
+      }
+
+      max_feature_count = std::max(max_feature_count, features[k].size());
+    }
+
+    for (usize i = 0; i < max_feature_count; i++) {
+      for (usize k = 0; k < positions.size(); k++) {
+        if (i < features[k].size())
+          Arch::add(net, out[k].values[0], features[k][i][0], out[k].values[1], features[k][i][1]);
+      }
+    }
+  }
+
+  template<typename Arch>
+  static auto evaluate_range(const typename Arch::Network& net, std::span<const Position> positions, std::span<Score> scores) -> void {
+    const auto state = std::make_unique<typename Arch::State>(net);
+    std::array<typename Arch::AccumulatorPair, interleave_count> accumulators;
+
+    for (usize i = 0; i < positions.size(); i += interleave_count) {
+      const usize count = std::min(interleave_count, positions.size() - i);
+      const std::span<const Position> group = positions.subspan(i, count);
+
+      rebuild_accumulators<Arch>(net, group, std::span {accumulators}.first(count));
+
+      for (usize k = 0; k < count; k++) {
+        state->reset(group[k], accumulators[k]);
+        scores[i + k] = state->evaluate(group[k]);
+      }
+    }
+  }
+
+  auto evaluate_batch(const LoadedNetwork& network, std::span<const Position> positions, std::span<Score> scores, usize thread_count) -> void {
+    rose_assert(positions.size() == scores.size());
+    thread_count = std::clamp<usize>(thread_count, 1, std::max<usize>(positions.size(), 1));
+
+    network.visit([&]<typename Arch>(const Arch::Network& net) {
+      std::vector<std::jthread> threads;
+      for (usize t = 0; t < thread_count; t++) {
+        const usize begin = positions.size() * t / thread_count;
+        const usize end = positions.size() * (t + 1) / thread_count;
+        threads.emplace_back(&evaluate_range<Arch>, std::cref(net), positions.subspan(begin, end - begin), scores.subspan(begin, end - begin));
+      }
+    });
+  }
+
+}  // namespace rose::eval::nnue
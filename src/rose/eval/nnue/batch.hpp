@@ -0,0 +1,16 @@
+#pragma once
+
+#include "rose/common.hpp"
+#include "rose/eval/nnue/network.hpp"
+#include "rose/position.hpp"
+#include "rose/score.hpp"
+
+#include <span>
+
+namespace rose::eval::nnue {
+
+  // Raw static evaluation of many positions, from the side to move's perspective, without running a search. The positions
+  // are split evenly across thread_count threads. scores must be the same size as positions.
+  auto evaluate_batch(const LoadedNetwork& network, std::span<const Position> positions, std::span<Score> scores, usize thread_count) -> void;
+
+}  // namespace rose::eval::nnue
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "rose/common.hpp"
+#include "rose/eval/nnue/arch.hpp"
+#include "rose/eval/nnue/network.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tuple>
+
+namespace rose::eval::nnue::container {
+
+  // A .rosenet file is a 64-byte Header followed by the raw network weights (the payload).
+  // The header is 64 bytes so that the payload keeps the alignment the SIMD kernels expect.
+
+  inline constexpr std::array<char, 8> magic {{'R', 'O', 'S', 'E', 'N', 'E', 'T', '\x1a'}};
+  inline constexpr u32 current_version = 2;
+
+  // Version 1 containers predate ft_weight_bits. The field was reserved and zero, and every network had i16 weights.
+  inline constexpr u32 version1_ft_weight_bits = 16;
+
+  struct Header {
+    std::array<char, 8> magic;
+    u32 version;
+    u32 hidden_size;
+    std::array<char, 16> arch;
+    i32 qa;
+    i32 qb;
+    i32 scale;
+    u32 ft_weight_bits;
+    u64 payload_size;
+    u64 content_hash;
+
+    auto arch_name() const -> std::string_view {
+      return {arch.data(), static_cast<usize>(std::ranges::find(arch, '\0') - arch.begin())};
+    }
+  };
+
+  static_assert(sizeof(Header) == 64);
+
+  inline auto content_hash(std::span<const std::byte> bytes) -> u64 {
+    constexpr u64 k = 0x9e3779b97f4a7c15;
+
+    u64 h = bytes.size() * k;
+    usize i = 0;
+    for (; i + sizeof(u64) <= bytes.size(); i += sizeof(u64)) {
+      u64 word;
+      std::memcpy(&word, bytes.data() + i, sizeof(u64));
+      h = (std::rotl(h, 27) ^ word) * k;
+    }
+    for (; i < bytes.size(); i++)
+      h = (std::rotl(h, 27) ^ static_cast<u64>(bytes[i])) * k;
+    return h ^ (h >> 32);
+  }
+
+  // Trainers pad the weights out to a multiple of 64 bytes, so accept either the exact or the padded size.
+  template<typename Arch>
+  constexpr auto payload_size_matches(usize size) -> bool {
+    constexpr usize network_size = sizeof(typename Arch::Network);
+    return size == network_size || size == (network_size + 63) / 64 * 64;
+  }
+
+  template<typename Arch>
+  auto make_header(std::span<const std::byte> payload) -> Header {
+    const std::string_view name = arch_name(arch_id_of<Arch>());
+
+    Header header {};
+    header.magic = magic;
+    header.version = current_version;
+    header.hidden_size = static_cast<u32>(Arch::hidden_size);
+    std::ranges::copy(name.substr(0, header.arch.size() - 1), header.arch.begin());
+    header.qa = Arch::qa;
+    header.qb = Arch::qb;
+    header.scale = Arch::scale;
+    header.ft_weight_bits = Arch::ft_weight_bits;
+    header.payload_size = payload.size();
+    header.content_hash = content_hash(payload);
+    return header;
+  }
+
+  // Verifies a whole container and returns the architecture and payload it describes.
+  inline auto parse(std::span<const std::byte> bytes) -> std::expected<std::tuple<ArchId, std::span<const std::byte>>, NetworkError> {
+    if (bytes.size() < sizeof(Header))
+      return std::unexpected(NetworkError::too_small);
+
+    Header header;
+    std::memcpy(&header, bytes.data(), sizeof(Header));
+    const std::span<const std::byte> payload = bytes.subspan(sizeof(Header));
+
+    if (header.magic != magic)
+      return std::unexpected(NetworkError::bad_magic);
+    if (header.version != current_version && header.version != 1)
+      return std::unexpected(NetworkError::unsupported_version);
+    const u32 ft_weight_bits = header.version == 1 ? version1_ft_weight_bits : header.ft_weight_bits;
+
+    const std::optional<ArchId> arch = parse_arch_name(header.arch_name());
+    if (!arch)
+      return std::unexpected(NetworkError::unknown_arch);
+
+    const std::optional<NetworkError> arch_error = visit_arch(*arch, [&]<typename Arch>() -> std::optional<NetworkError> {
+      if (header.hidden_size != Arch::hidden_size)
+        return NetworkError::hidden_size_mismatch;
+      if (header.qa != Arch::qa || header.qb != Arch::qb || header.scale != Arch::scale || ft_weight_bits != Arch::ft_weight_bits)
+        return NetworkError::quantisation_mismatch;
+      if (header.payload_size != payload.size() || !payload_size_matches<Arch>(payload.size()))
+        return NetworkError::payload_size_mismatch;
+      return std::nullopt;
+    });
+    if (arch_error)
+      return std::unexpected(*arch_error);
+
+    if (header.content_hash != content_hash(payload))
+      return std::unexpected(NetworkError::checksum_mismatch);
+
+    return std::tuple {*arch, payload};
+  }
+
+}  // namespace rose::eval::nnue::container
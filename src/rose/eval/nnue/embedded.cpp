@@ -1,9 +1,13 @@
 #include "rose/eval/nnue/embedded.hpp"
 
+#include "rose/common.hpp"
+
 namespace rose::eval::nnue {
 
-  alignas(EmbeddedNetwork) const char g_embedded_network_raw[] = {
+  alignas(64) const char g_embedded_network_raw[] = {
 #embed ROSE_NETWORK_FILE
   };
 
+  const usize g_embedded_network_size = sizeof(g_embedded_network_raw);
+
 }  // namespace rose::eval::nnue
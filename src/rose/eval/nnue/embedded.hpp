@@ -1,16 +1,11 @@
 #pragma once
 
-#include "rose/eval/nnue/kyanite.hpp"
+#include "rose/common.hpp"
 
 namespace rose::eval::nnue {
 
-  using EmbeddedArch = Kyanite<768>;
-  using EmbeddedNetwork = EmbeddedArch::Network;
-
-  alignas(EmbeddedNetwork) extern const char g_embedded_network_raw[];
-
-  inline auto embedded_network() -> const EmbeddedNetwork& {
-    return *reinterpret_cast<const EmbeddedNetwork*>(&g_embedded_network_raw[0]);
-  }
+  // A complete .rosenet container; see container.hpp. Use LoadedNetwork::embedded() to access it.
+  alignas(64) extern const char g_embedded_network_raw[];
+  extern const usize g_embedded_network_size;
 
 }  // namespace rose::eval::nnue
@@ -0,0 +1,409 @@
+#pragma once
+
+#include "rose/bitboard.hpp"
+#include "rose/board.hpp"
+#include "rose/common.hpp"
+#include "rose/eval/concepts.hpp"
+#include "rose/limits.hpp"
+#include "rose/position.hpp"
+#include "rose/square.hpp"
+#include "rose/util/assert.hpp"
+#include "rose/util/static_vector.hpp"
+
+#include <algorithm>
+#include <array>
+#include <lps/lps.hpp>
+#include <optional>
+#include <type_traits>
+
+namespace rose::eval::nnue {
+
+  // Maps the king square, seen from the perspective's own side and mirrored onto files a-d, to an input bucket. The
+  // layout runs rank by rank from a1 (a1 b1 c1 d1 a2 ...), matching bullet's ChessBucketsMirrored.
+  template<std::array<u8, 32> bucket_layout>
+  struct KingBuckets {
+    inline static constexpr std::array<u8, 32> layout = bucket_layout;
+    inline static constexpr usize count = *std::ranges::max_element(bucket_layout) + 1;
+  };
+
+  using NoKingBuckets = KingBuckets<std::array<u8, 32> {}>;
+
+  // The (768 x buckets -> hl_size)x2 feature transformer shared by the Kyanite and Garnet architectures: feature indexing,
+  // incremental accumulator updates, and refreshes when a king changes refresh key. The architectures add their own layers
+  // on top of the accumulators.
+  //
+  // FtWeight is the storage type of the feature transformer weights. Storing them as i8 halves the working set of the
+  // incremental updates; the weights are sign-extended as they are loaded and the accumulators remain i16.
+  // InputBuckets selects one of several sets of feature transformer weights by the position of the perspective's king.
+  template<usize hl_size, typename FtWeight = i16, typename InputBuckets = NoKingBuckets>
+  struct FeatureTransformer {
+    static_assert(std::is_same_v<FtWeight, i16> || std::is_same_v<FtWeight, i8>);
+
+    inline static constexpr usize input_size = 768 * InputBuckets::count;
+    inline static constexpr usize hidden_size = hl_size;
+    inline static constexpr u32 ft_weight_bits = 8 * sizeof(FtWeight);
+
+    inline static auto king_bucket(Square king_sq, Color perspective) -> usize {
+      if constexpr (InputBuckets::count == 1) {
+        return 0;
+      } else {
+        const u8 relative = king_sq.raw ^ (perspective == Color::black ? 0b111000 : 0);
+        const u8 file = (relative & 7) ^ ((relative & 4) ? 0b111 : 0);
+        return InputBuckets::layout[(relative >> 3) * 4 + file];
+      }
+    }
+
+    // Two king squares share a refresh key exactly when every feature has the same index for both of them.
+    inline static constexpr usize refresh_key_count = 2 * InputBuckets::count;
+
+    inline static auto refresh_key(Square king_sq, Color perspective) -> usize {
+      return 2 * king_bucket(king_sq, perspective) + (king_sq.file() >= 4 ? 1 : 0);
+    }
+
+    inline static auto feature_index(const Position& pos, Color perspective, Square sq, PieceType ptype, Color side) -> usize {
+      //                          qrb-npk-
+      constexpr u32 ptype_lut = 0x43201050;
+
+      const Square king_sq = pos.king_sq(perspective);
+
+      usize side_index = side.to_index();
+      usize ptype_index = (ptype_lut >> (4 * ptype.to_index())) & 0xf;
+      usize square_index = sq.raw ^ (king_sq.file() >= 4 ? 0b000111 : 0);
+
+      if (perspective == Color::black) {
+        side_index ^= 1;
+        square_index ^= 0b111000;
+      }
+
+      return king_bucket(king_sq, perspective) * 768 + side_index * 64 * 6 + ptype_index * 64 + square_index;
+    }
+
+    using Accumulator = std::array<i16, hl_size>;
+
+    struct alignas(64) AccumulatorPair {
+      std::array<Accumulator, 2> values;
+
+      const Accumulator& get(Color color) const {
+        return values[color.to_index()];
+      }
+
+      inline constexpr auto operator==(const AccumulatorPair&) const -> bool = default;
+    };
+
+    // The leading part of every network file that uses this feature transformer.
+    struct Weights {
+      std::array<std::array<FtWeight, hl_size>, input_size> accumulator_weights;
+      Accumulator accumulator_biases;
+    };
+
+    inline static auto load_weights(const FtWeight* src) -> i16xN {
+      using FtWeightxN = vector<FtWeight, i16xN::size>;
+
+      if constexpr (std::is_same_v<FtWeight, i16>) {
+        return i16xN::load(src);
+      } else if constexpr (!std::is_void_v<FtWeightxN>) {
+        return FtWeightxN::load(src).template convert<i16>();
+      } else {
+        // No half-width i8 vector on this backend.
+        alignas(64) std::array<i16, i16xN::size> widened;
+        std::copy_n(src, i16xN::size, widened.begin());
+        return i16xN::load(widened.data());
+      }
+    }
+
+    inline static auto add(const Weights& net, Accumulator& acc, usize feat) -> void {
+      static_assert(hl_size % i16xN::size == 0);
+
+      for (usize i = 0; i < hl_size; i += i16xN::size)
+        (i16xN::load(&acc[i]) + load_weights(&net.accumulator_weights[feat][i])).store(&acc[i]);
+    }
+
+    inline static auto sub(const Weights& net, Accumulator& acc, usize feat) -> void {
+      static_assert(hl_size % i16xN::size == 0);
+
+      for (usize i = 0; i < hl_size; i += i16xN::size)
+        (i16xN::load(&acc[i]) - load_weights(&net.accumulator_weights[feat][i])).store(&acc[i]);
+    }
+
+    inline static auto add(const Weights& net, Accumulator& acc0, usize feat0, Accumulator& acc1, usize feat1) -> void {
+      static_assert(hl_size % i16xN::size == 0);
+
+      for (usize i = 0; i < hl_size; i += i16xN::size) {
+        const i16xN w0 = load_weights(&net.accumulator_weights[feat0][i]);
+        const i16xN w1 = load_weights(&net.accumulator_weights[feat1][i]);
+        (i16xN::load(&acc0[i]) + w0).store(&acc0[i]);
+        (i16xN::load(&acc1[i]) + w1).store(&acc1[i]);
+      }
+    }
+
+    inline static auto sub(const Weights& net, Accumulator& acc0, usize feat0, Accumulator& acc1, usize feat1) -> void {
+      static_assert(hl_size % i16xN::size == 0);
+
+      for (usize i = 0; i < hl_size; i += i16xN::size) {
+        const i16xN w0 = load_weights(&net.accumulator_weights[feat0][i]);
+        const i16xN w1 = load_weights(&net.accumulator_weights[feat1][i]);
+        (i16xN::load(&acc0[i]) - w0).store(&acc0[i]);
+        (i16xN::load(&acc1[i]) - w1).store(&acc1[i]);
+      }
+    }
+
+    inline static auto subadd(const Weights& net, Accumulator& acc0, usize sub0, usize add0, Accumulator& acc1, usize sub1, usize add1) -> void {
+      static_assert(hl_size % i16xN::size == 0);
+
+      for (usize i = 0; i < hl_size; i += i16xN::size) {
+        const i16xN w_sub0 = load_weights(&net.accumulator_weights[sub0][i]);
+        const i16xN w_sub1 = load_weights(&net.accumulator_weights[sub1][i]);
+        const i16xN w_add0 = load_weights(&net.accumulator_weights[add0][i]);
+        const i16xN w_add1 = load_weights(&net.accumulator_weights[add1][i]);
+        (i16xN::load(&acc0[i]) - w_sub0 + w_add0).store(&acc0[i]);
+        (i16xN::load(&acc1[i]) - w_sub1 + w_add1).store(&acc1[i]);
+      }
+    }
+
+    inline static auto rebuild_accumulator(const Position& pos, const Weights& net) -> AccumulatorPair {
+      AccumulatorPair result;
+      result.values.fill(net.accumulator_biases);
+
+      for (u8 i = 0; i < 64; i++) {
+        const Square sq {i};
+        const Place p = pos.place_at(sq);
+
+        if (p.is_empty())
+          continue;
+
+        const usize feature0 = feature_index(pos, Color::white, sq, p.ptype(), p.color());
+        const usize feature1 = feature_index(pos, Color::black, sq, p.ptype(), p.color());
+
+        add(net, result.values[0], feature0, result.values[1], feature1);
+      }
+
+      return result;
+    }
+
+    // Squares whose piece differs between two boards. Piece ids are irrelevant to the features.
+    inline static auto changed_squares(const Byteboard& a, const Byteboard& b) -> Bitboard {
+      const u8x64 mask = u8x64::splat(Place::color_mask | Place::ptype_mask);
+      return Bitboard {(a.to_vector() & mask).neq(b.to_vector() & mask).to_bits()};
+    }
+
+    // Brings acc from the board `from` to the board of pos. Both boards must have the same refresh key for perspective.
+    inline static auto apply_changes(const Weights& net, const Position& pos, Color perspective, const Byteboard& from, Bitboard changes, Accumulator& acc)
+      -> void {
+      for (const Square sq : changes) {
+        const Place old_place = from[sq];
+        const Place new_place = pos.place_at(sq);
+        if (!old_place.is_empty())
+          sub(net, acc, feature_index(pos, perspective, sq, old_place.ptype(), old_place.color()));
+        if (!new_place.is_empty())
+          add(net, acc, feature_index(pos, perspective, sq, new_place.ptype(), new_place.color()));
+      }
+    }
+
+    // Accumulator cache for refreshes. Each perspective has one entry per refresh key, holding the accumulator of the board
+    // last refreshed with that key. A refresh then only applies the squares that differ from that board, which is usually
+    // far fewer than the pieces on the board.
+    struct RefreshTable {
+      struct Entry {
+        Accumulator accumulator;
+        Byteboard board;
+      };
+
+    private:
+      std::array<std::array<Entry, refresh_key_count>, 2> m_entries;
+
+    public:
+      explicit RefreshTable(const Weights& net) {
+        for (auto& perspective_entries : m_entries) {
+          for (Entry& entry : perspective_entries) {
+            entry.accumulator = net.accumulator_biases;
+            entry.board = {};
+          }
+        }
+      }
+
+      auto entry(Color perspective, usize key) -> Entry& {
+        return m_entries[perspective.to_index()][key];
+      }
+    };
+
+    // The accumulators of one ply, with the board and refresh keys they were computed for, so that a later refresh can
+    // start from them.
+    struct StackEntry {
+      AccumulatorPair accumulators;
+      Byteboard board;
+      std::array<usize, 2> refresh_keys;
+
+      static auto from_position(const Position& pos, const AccumulatorPair& accumulators) -> StackEntry {
+        return StackEntry {
+          .accumulators = accumulators,
+          .board = pos.board(),
+          .refresh_keys = {{
+            refresh_key(pos.king_sq(Color::white), Color::white),
+            refresh_key(pos.king_sq(Color::black), Color::black),
+          }},
+        };
+      }
+    };
+
+    using Stack = StaticVector<StackEntry, max_depth + 6>;
+
+    struct Observer {
+    private:
+      const Weights& m_net;
+      Stack& m_stack;
+      AccumulatorPair& m_accum;
+      RefreshTable& m_refresh_table;
+      std::optional<Square> m_king_from;
+      Color m_king_color = Color::white;
+
+      // Starts from whichever is closer to the current board: the nearest ancestor on the stack with the same refresh key,
+      // or the refresh table's entry. The ancestor usually wins when a king steps across the centre and back.
+      auto refresh(const Position& pos, Color perspective) -> void {
+        const usize index = perspective.to_index();
+        const usize key = refresh_key(pos.king_sq(perspective), perspective);
+        Accumulator& acc = m_accum.values[index];
+
+        typename RefreshTable::Entry& cached = m_refresh_table.entry(perspective, key);
+        const Bitboard cached_changes = changed_squares(cached.board, pos.board());
+
+        for (usize i = m_stack.size() - 1; i-- > 0;) {
+          const StackEntry& ancestor = m_stack[i];
+          if (ancestor.refresh_keys[index] != key)
+            continue;
+
+          const Bitboard changes = changed_squares(ancestor.board, pos.board());
+          if (changes.popcount() < cached_changes.popcount()) {
+            acc = ancestor.accumulators.values[index];
+            apply_changes(m_net, pos, perspective, ancestor.board, changes, acc);
+            return;
+          }
+          break;
+        }
+
+        apply_changes(m_net, pos, perspective, cached.board, cached_changes, cached.accumulator);
+        cached.board = pos.board();
+        acc = cached.accumulator;
+      }
+
+    public:
+      Observer(const Weights& net, Stack& stack, RefreshTable& refresh_table) :
+          m_net(net),
+          m_stack(stack),
+          m_accum(stack.back().accumulators),
+          m_refresh_table(refresh_table) {
+      }
+
+      // For castling, `to` is the rook square, so the king's destination is only known in on_finalize.
+      auto on_king_move(const Position& pos, Color stm, Square from, Square to) -> void {
+        m_king_from = from;
+        m_king_color = stm;
+      }
+
+      auto on_add(const Position& pos, Color side, PieceType ptype, Square sq) -> void {
+        add(m_net,
+            m_accum.values[0],
+            feature_index(pos, Color::white, sq, ptype, side),
+            m_accum.values[1],
+            feature_index(pos, Color::black, sq, ptype, side));
+      }
+
+      auto on_remove(const Position& pos, Color side, PieceType ptype, Square sq) -> void {
+        sub(m_net,
+            m_accum.values[0],
+            feature_index(pos, Color::white, sq, ptype, side),
+            m_accum.values[1],
+            feature_index(pos, Color::black, sq, ptype, side));
+      }
+
+      auto on_mutate(const Position& pos, Color side, PieceType src_ptype, PieceType dst_ptype, Square sq) -> void {
+        subadd(m_net,
+               m_accum.values[0],
+               feature_index(pos, Color::white, sq, src_ptype, side),
+               feature_index(pos, Color::white, sq, dst_ptype, side),
+               m_accum.values[1],
+               feature_index(pos, Color::black, sq, src_ptype, side),
+               feature_index(pos, Color::black, sq, dst_ptype, side));
+      }
+
+      auto on_move(const Position& pos, Color side, PieceType ptype, Square from, Square to) -> void {
+        subadd(m_net,
+               m_accum.values[0],
+               feature_index(pos, Color::white, from, ptype, side),
+               feature_index(pos, Color::white, to, ptype, side),
+               m_accum.values[1],
+               feature_index(pos, Color::black, from, ptype, side),
+               feature_index(pos, Color::black, to, ptype, side));
+      }
+
+      auto on_promote(const Position& pos, Color side, PieceType dst_ptype, Square from, Square to) -> void {
+        subadd(m_net,
+               m_accum.values[0],
+               feature_index(pos, Color::white, from, PieceType::p, side),
+               feature_index(pos, Color::white, to, dst_ptype, side),
+               m_accum.values[1],
+               feature_index(pos, Color::black, from, PieceType::p, side),
+               feature_index(pos, Color::black, to, dst_ptype, side));
+      }
+
+      // The incremental updates above used the old king square, so they are only valid for the perspective whose king
+      // did not move, or whose king stayed under the same refresh key.
+      auto on_finalize(const Position& pos) -> void {
+        if (m_king_from && refresh_key(*m_king_from, m_king_color) != refresh_key(pos.king_sq(m_king_color), m_king_color)) {
+          refresh(pos, m_king_color);
+        }
+
+        StackEntry& top = m_stack.back();
+        top.board = pos.board();
+        top.refresh_keys[m_king_color.to_index()] = refresh_key(pos.king_sq(m_king_color), m_king_color);
+      }
+    };
+
+    static_assert(concepts::Observer<Observer>);
+
+    // The accumulator stack of a search, one entry per ply, together with the refresh table its refreshes go through.
+    struct AccumulatorStack {
+    private:
+      Stack m_stack;
+      const Weights& m_net;
+      RefreshTable m_refresh_table;
+
+    public:
+      explicit AccumulatorStack(const Weights& net) :
+          m_net(net),
+          m_refresh_table(net) {
+      }
+
+      auto reset(const Position& pos) -> void {
+        m_stack.clear();
+        m_stack.push_back(StackEntry::from_position(pos, rebuild_accumulator(pos, m_net)));
+      }
+
+      // Starts from accumulators that were computed elsewhere, such as by batch evaluation.
+      auto reset(const Position& pos, const AccumulatorPair& accumulators) -> void {
+        m_stack.clear();
+        m_stack.push_back(StackEntry::from_position(pos, accumulators));
+      }
+
+      auto push() -> void {
+        m_stack.push_back(m_stack.back());
+      }
+
+      auto pop() -> void {
+        m_stack.pop_back();
+      }
+
+      // The accumulators of pos, which must be the position the stack was last reset to or moved to.
+      auto get(const Position& pos) const -> const AccumulatorPair& {
+        const AccumulatorPair& accumulators = m_stack.back().accumulators;
+        rose_assert(rebuild_accumulator(pos, m_net) == accumulators);
+        rose_unused(pos);
+        return accumulators;
+      }
+
+      auto observer() -> Observer {
+        return Observer {m_net, m_stack, m_refresh_table};
+      }
+    };
+  };
+
+}  // namespace rose::eval::nnue
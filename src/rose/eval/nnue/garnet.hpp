@@ -0,0 +1,225 @@
+#pragma once
+
+#include "rose/common.hpp"
+#include "rose/eval/nnue/feature_transformer.hpp"
+#include "rose/position.hpp"
+#include "rose/score.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <lps/lps.hpp>
+
+namespace rose::eval::nnue {
+
+  // (768 x buckets -> hl_size)x2 -> l1_size -> l2_size -> 1
+  //
+  // The feature transformer is Kyanite's, with the same weight types and input buckets. Its clipped activations are mostly
+  // zero, so the first layer only visits the four-byte chunks of the input that have a non-zero activation in them. The
+  // first layer is evaluated with u8 x i8 multiplies; activations are clipped to [0, qa] with qa = 127 so that these can
+  // never saturate.
+  template<usize hl_size, usize l1_size, usize l2_size, typename FtWeight = i16, typename InputBuckets = NoKingBuckets>
+  struct Garnet : FeatureTransformer<hl_size, FtWeight, InputBuckets> {
+    using Transformer = FeatureTransformer<hl_size, FtWeight, InputBuckets>;
+    using typename Transformer::Accumulator;
+    using typename Transformer::AccumulatorPair;
+    using typename Transformer::AccumulatorStack;
+
+    inline static constexpr i32 scale = 400;
+    inline static constexpr i32 qa = 127;
+    inline static constexpr i32 qb_shift = 6;
+    inline static constexpr i32 qb = 1 << qb_shift;
+
+    inline static constexpr usize l1_input_size = 2 * hl_size;
+    inline static constexpr usize l1_output_size = l1_size;
+    inline static constexpr usize l2_output_size = l2_size;
+    inline static constexpr usize chunk_size = 4;
+    inline static constexpr usize chunk_count = l1_input_size / chunk_size;
+
+    static_assert(hl_size % 32 == 0);
+    static_assert(l1_size % 4 == 0);
+
+    struct Network : Transformer::Weights {
+      std::array<std::array<i8, l1_size>, l1_input_size> l1_weights;
+      std::array<i32, l1_size> l1_biases;
+      std::array<std::array<i8, l2_size>, l1_size> l2_weights;
+      std::array<i32, l2_size> l2_biases;
+      std::array<i8, l2_size> l3_weights;
+      i32 l3_bias;
+    };
+
+    // Runtime layout of the layers after the feature transformer, built from the file layout when a State is constructed.
+    // The first layer is stored chunk-major: the l1_size x 4 weights that one input chunk contributes are contiguous, so
+    // that a non-zero chunk costs a single load.
+    struct Layers {
+      alignas(64) std::array<std::array<i8, chunk_size * l1_size>, chunk_count> l1_weights;
+      alignas(64) std::array<i32, l1_size> l1_biases;
+      std::array<std::array<i8, l2_size>, l1_size> l2_weights;
+      std::array<i32, l2_size> l2_biases;
+      std::array<i8, l2_size> l3_weights;
+      i32 l3_bias;
+
+      static auto from_network(const Network& net) -> Layers {
+        Layers result;
+        for (usize chunk = 0; chunk < chunk_count; chunk++)
+          for (usize j = 0; j < l1_size; j++)
+            for (usize k = 0; k < chunk_size; k++)
+              result.l1_weights[chunk][j * chunk_size + k] = net.l1_weights[chunk * chunk_size + k][j];
+        result.l1_biases = net.l1_biases;
+        result.l2_weights = net.l2_weights;
+        result.l2_biases = net.l2_biases;
+        result.l3_weights = net.l3_weights;
+        result.l3_bias = net.l3_bias;
+        return result;
+      }
+    };
+
+    // Activations are written a whole vector at a time, which may run past the end on narrow backends.
+    inline static constexpr usize activation_padding = 64;
+    using Activations = std::array<u8, l1_input_size + activation_padding>;
+
+    // One entry per non-zero chunk, plus room for a whole vector of indices written past the last one.
+    using NonZeroChunks = std::array<u32, chunk_count + 16>;
+
+    // Clips one perspective's accumulator to [0, qa] and narrows it to u8.
+    inline static auto activate(const Accumulator& acc, u8* dst) -> void {
+      for (usize i = 0; i < hl_size; i += i16xN::size) {
+        const i16xN clipped = i16xN::load(&acc[i]).clamp(i16xN::zero(), i16xN::splat(qa));
+        clipped.template convert<u8>().store(dst + i);
+      }
+    }
+
+    // Writes the indices of the non-zero chunks of the activations in increasing order and returns how many there are.
+    inline static auto find_nonzero_chunks(const Activations& activations, NonZeroChunks& nnz) -> usize {
+      static_assert(chunk_count % i32xN::size == 0);
+
+      usize count = 0;
+      for (usize i = 0; i < chunk_count; i += i32xN::size) {
+        const auto nonzero = i32xN::load(&activations[i * chunk_size]).nonzeros();
+#if LPS_AVX512
+        constexpr std::array<i32, 16> lane_indices {{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}};
+        const i32xN indices = i32xN::splat(static_cast<i32>(i)) + i32xN::load(lane_indices.data());
+        nonzero.compress(indices).store(&nnz[count]);
+        count += nonzero.popcount();
+#else
+        for (u32 bits = nonzero.to_bits(); bits != 0; bits &= bits - 1)
+          nnz[count++] = static_cast<u32>(i + std::countr_zero(bits));
+#endif
+      }
+      return count;
+    }
+
+    // First layer before its activation, visiting only the non-zero chunks. The outputs are split into groups of one
+    // native i32 vector each, so that no backend has to emulate wider vectors.
+    inline static auto l1_forward(const Layers& layers, const Activations& activations) -> std::array<i32, l1_size> {
+      constexpr usize group_size = i32xN::size;
+      constexpr usize group_count = l1_size / group_size;
+      static_assert(l1_size % group_size == 0);
+
+      using u8xG = vector<u8, chunk_size * group_size>;
+      using i8xG = vector<i8, chunk_size * group_size>;
+      using i16xG = vector<i16, 2 * group_size>;
+
+      alignas(64) NonZeroChunks nnz;
+      const usize nnz_count = find_nonzero_chunks(activations, nnz);
+
+      std::array<i32xN, group_count> output;
+      for (usize g = 0; g < group_count; g++)
+        output[g] = i32xN::load(&layers.l1_biases[g * group_size]);
+
+      for (usize n = 0; n < nnz_count; n++) {
+        const usize chunk = nnz[n];
+
+        u32 packed;
+        std::memcpy(&packed, &activations[chunk * chunk_size], sizeof(packed));
+
+        // Each i32 lane holds the same four activations, which meet that output's four weights in the pair dots.
+        // The u8 x i8 pair dot is signed, even though lps types its result as u16.
+        const u8xG inputs = std::bit_cast<u8xG>(i32xN::splat(static_cast<i32>(packed)));
+        for (usize g = 0; g < group_count; g++) {
+          const i8xG weights = i8xG::load(&layers.l1_weights[chunk][g * chunk_size * group_size]);
+          const i16xG pairs = std::bit_cast<i16xG>(inputs.pair_dot(weights));
+          output[g] += pairs.pair_dot(i16xG::splat(1));
+        }
+      }
+
+      alignas(64) std::array<i32, l1_size> result;
+      for (usize g = 0; g < group_count; g++)
+        output[g].store(&result[g * group_size]);
+      return result;
+    }
+
+    inline static auto evaluate(const Layers& layers, const Accumulator& us, const Accumulator& them) -> i32 {
+      alignas(64) Activations activations;
+      activate(us, &activations[0]);
+      activate(them, &activations[hl_size]);
+
+      const std::array<i32, l1_size> l1_output = l1_forward(layers, activations);
+
+      std::array<i32, l1_size> l1_activations;
+      for (usize j = 0; j < l1_size; j++)
+        l1_activations[j] = std::clamp(l1_output[j] >> qb_shift, 0, qa);
+
+      std::array<i32, l2_size> l2_activations = layers.l2_biases;
+      for (usize j = 0; j < l1_size; j++)
+        for (usize k = 0; k < l2_size; k++)
+          l2_activations[k] += l1_activations[j] * layers.l2_weights[j][k];
+      for (i32& x : l2_activations)
+        x = std::clamp(x >> qb_shift, 0, qa);
+
+      i32 output = layers.l3_bias;
+      for (usize k = 0; k < l2_size; k++)
+        output += l2_activations[k] * layers.l3_weights[k];
+
+      return static_cast<i32>(static_cast<i64>(output) * scale / (qa * qb));
+    }
+
+    // Architectures can share a feature transformer, but Position::move is explicitly instantiated once per architecture,
+    // so each one needs its own observer type.
+    struct Observer : Transformer::Observer {
+      explicit Observer(const Transformer::Observer& observer) :
+          Transformer::Observer(observer) {
+      }
+    };
+
+    struct State {
+    private:
+      AccumulatorStack m_accumulators;
+      Layers m_layers;
+
+    public:
+      explicit State(const Network& net) :
+          m_accumulators(net),
+          m_layers(Layers::from_network(net)) {
+      }
+
+      auto reset(const Position& pos) -> void {
+        m_accumulators.reset(pos);
+      }
+
+      auto reset(const Position& pos, const AccumulatorPair& accumulators) -> void {
+        m_accumulators.reset(pos, accumulators);
+      }
+
+      auto push() -> void {
+        m_accumulators.push();
+      }
+
+      auto pop() -> void {
+        m_accumulators.pop();
+      }
+
+      auto evaluate(const Position& pos) -> Score {
+        const Color stm = pos.stm();
+        const AccumulatorPair& accumulators = m_accumulators.get(pos);
+        return Garnet::evaluate(m_layers, accumulators.get(stm), accumulators.get(stm.invert()));
+      }
+
+      auto observer() -> Observer {
+        return Observer {m_accumulators.observer()};
+      }
+    };
+  };
+
+}  // namespace rose::eval::nnue
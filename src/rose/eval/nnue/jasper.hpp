@@ -9,18 +9,24 @@
 #include "rose/util/assert.hpp"
 #include "rose/util/static_vector.hpp"
 
+#include <algorithm>
 #include <array>
+#include <lps/lps.hpp>
 
 namespace rose::eval::nnue {
 
   template<usize hl_size>
   struct Jasper {
     inline static constexpr usize input_size = 768;
+    inline static constexpr usize hidden_size = hl_size;
+    inline static constexpr u32 ft_weight_bits = 16;
     inline static constexpr i32 scale = 400;
     inline static constexpr i32 qa = 255;
     inline static constexpr i32 qb = 64;
 
-    inline static auto feature_index(Color perspective, Square sq, PieceType ptype, Color side) -> usize {
+    inline static auto feature_index(const Position& pos, Color perspective, Square sq, PieceType ptype, Color side) -> usize {
+      rose_unused(pos);
+
       //                          qrb-npk-
       constexpr u32 ptype_lut = 0x43201050;
 
@@ -38,7 +44,7 @@ namespace rose::eval::nnue {
 
     using Accumulator = std::array<i16, hl_size>;
 
-    struct AccumulatorPair {
+    struct alignas(64) AccumulatorPair {
       std::array<Accumulator, 2> values;
 
       const Accumulator& get(Color color) const {
@@ -55,14 +61,39 @@ namespace rose::eval::nnue {
       i16 output_bias;
     };
 
-    inline static auto add(const Network& net, Accumulator& accumulator, usize feature) -> void {
-      for (usize i = 0; i < hl_size; i++)
-        accumulator[i] += net.accumulator_weights[feature][i];
+    inline static auto add(const Network& net, Accumulator& acc0, usize feat0, Accumulator& acc1, usize feat1) -> void {
+      static_assert(hl_size % i16xN::size == 0);
+
+      for (usize i = 0; i < hl_size; i += i16xN::size) {
+        const i16xN w0 = i16xN::load(&net.accumulator_weights[feat0][i]);
+        const i16xN w1 = i16xN::load(&net.accumulator_weights[feat1][i]);
+        (i16xN::load(&acc0[i]) + w0).store(&acc0[i]);
+        (i16xN::load(&acc1[i]) + w1).store(&acc1[i]);
+      }
+    }
+
+    inline static auto sub(const Network& net, Accumulator& acc0, usize feat0, Accumulator& acc1, usize feat1) -> void {
+      static_assert(hl_size % i16xN::size == 0);
+
+      for (usize i = 0; i < hl_size; i += i16xN::size) {
+        const i16xN w0 = i16xN::load(&net.accumulator_weights[feat0][i]);
+        const i16xN w1 = i16xN::load(&net.accumulator_weights[feat1][i]);
+        (i16xN::load(&acc0[i]) - w0).store(&acc0[i]);
+        (i16xN::load(&acc1[i]) - w1).store(&acc1[i]);
+      }
     }
 
-    inline static auto sub(const Network& net, Accumulator& accumulator, usize feature) -> void {
-      for (usize i = 0; i < hl_size; i++)
-        accumulator[i] -= net.accumulator_weights[feature][i];
+    inline static auto subadd(const Network& net, Accumulator& acc0, usize sub0, usize add0, Accumulator& acc1, usize sub1, usize add1) -> void {
+      static_assert(hl_size % i16xN::size == 0);
+
+      for (usize i = 0; i < hl_size; i += i16xN::size) {
+        const i16xN w_sub0 = i16xN::load(&net.accumulator_weights[sub0][i]);
+        const i16xN w_sub1 = i16xN::load(&net.accumulator_weights[sub1][i]);
+        const i16xN w_add0 = i16xN::load(&net.accumulator_weights[add0][i]);
+        const i16xN w_add1 = i16xN::load(&net.accumulator_weights[add1][i]);
+        (i16xN::load(&acc0[i]) - w_sub0 + w_add0).store(&acc0[i]);
+        (i16xN::load(&acc1[i]) - w_sub1 + w_add1).store(&acc1[i]);
+      }
     }
 
     inline static auto screlu(i16 x) -> i32 {
@@ -86,28 +117,49 @@ namespace rose::eval::nnue {
       }
 
       auto on_add(const Position& pos, Color side, PieceType ptype, Square sq) -> void {
-        add(m_net, m_accum.values[0], feature_index(Color::white, sq, ptype, side));
-        add(m_net, m_accum.values[1], feature_index(Color::black, sq, ptype, side));
+        add(m_net,
+            m_accum.values[0],
+            feature_index(pos, Color::white, sq, ptype, side),
+            m_accum.values[1],
+            feature_index(pos, Color::black, sq, ptype, side));
       }
 
       auto on_remove(const Position& pos, Color side, PieceType ptype, Square sq) -> void {
-        sub(m_net, m_accum.values[0], feature_index(Color::white, sq, ptype, side));
-        sub(m_net, m_accum.values[1], feature_index(Color::black, sq, ptype, side));
+        sub(m_net,
+            m_accum.values[0],
+            feature_index(pos, Color::white, sq, ptype, side),
+            m_accum.values[1],
+            feature_index(pos, Color::black, sq, ptype, side));
       }
 
       auto on_mutate(const Position& pos, Color side, PieceType src_ptype, PieceType dst_ptype, Square sq) -> void {
-        on_remove(pos, side, src_ptype, sq);
-        on_add(pos, side, dst_ptype, sq);
+        subadd(m_net,
+               m_accum.values[0],
+               feature_index(pos, Color::white, sq, src_ptype, side),
+               feature_index(pos, Color::white, sq, dst_ptype, side),
+               m_accum.values[1],
+               feature_index(pos, Color::black, sq, src_ptype, side),
+               feature_index(pos, Color::black, sq, dst_ptype, side));
       }
 
       auto on_move(const Position& pos, Color side, PieceType ptype, Square from, Square to) -> void {
-        on_remove(pos, side, ptype, from);
-        on_add(pos, side, ptype, to);
+        subadd(m_net,
+               m_accum.values[0],
+               feature_index(pos, Color::white, from, ptype, side),
+               feature_index(pos, Color::white, to, ptype, side),
+               m_accum.values[1],
+               feature_index(pos, Color::black, from, ptype, side),
+               feature_index(pos, Color::black, to, ptype, side));
       }
 
       auto on_promote(const Position& pos, Color side, PieceType dst_ptype, Square from, Square to) -> void {
-        on_remove(pos, side, PieceType::p, from);
-        on_add(pos, side, dst_ptype, to);
+        subadd(m_net,
+               m_accum.values[0],
+               feature_index(pos, Color::white, from, PieceType::p, side),
+               feature_index(pos, Color::white, to, dst_ptype, side),
+               m_accum.values[1],
+               feature_index(pos, Color::black, from, PieceType::p, side),
+               feature_index(pos, Color::black, to, dst_ptype, side));
       }
 
       auto on_finalize(const Position& pos) -> void {
@@ -133,22 +185,32 @@ namespace rose::eval::nnue {
           if (p.is_empty())
             continue;
 
-          const usize feature0 = feature_index(Color::white, sq, p.ptype(), p.color());
-          const usize feature1 = feature_index(Color::black, sq, p.ptype(), p.color());
+          const usize feature0 = feature_index(pos, Color::white, sq, p.ptype(), p.color());
+          const usize feature1 = feature_index(pos, Color::black, sq, p.ptype(), p.color());
 
-          add(m_net, result.values[0], feature0);
-          add(m_net, result.values[1], feature1);
+          add(m_net, result.values[0], feature0, result.values[1], feature1);
         }
 
         return result;
       }
 
+      // Same kernel as Kyanite::evaluate: screlu(x) * w is computed as (clamp(x) * w) * clamp(x), which relies on the
+      // output weights being small enough that clamp(x) * w fits in an i16.
       auto evaluate(const Accumulator& us, const Accumulator& them) -> i32 {
-        i32 output = 0;
-        for (usize i = 0; i < hl_size; i++) {
-          output += screlu(us[i]) * m_net.output_weights[0][i];
-          output += screlu(them[i]) * m_net.output_weights[1][i];
+        static_assert(hl_size % i16xN::size == 0);
+
+        i32xN output0 = i32xN::zero();
+        i32xN output1 = i32xN::zero();
+        for (usize i = 0; i < hl_size; i += i16xN::size) {
+          const i16xN w0 = i16xN::load(&m_net.output_weights[0][i]);
+          const i16xN w1 = i16xN::load(&m_net.output_weights[1][i]);
+          const i16xN c0_i = i16xN::load(&us[i]).clamp(i16xN::zero(), i16xN::splat(qa));
+          const i16xN c1_i = i16xN::load(&them[i]).clamp(i16xN::zero(), i16xN::splat(qa));
+          output0 = output0.accumulate_pair_dot(w0 * c0_i, c0_i);
+          output1 = output1.accumulate_pair_dot(w1 * c1_i, c1_i);
         }
+
+        i32 output = (output0 + output1).reduce_add();
         output /= qa;
         output += m_net.output_bias;
         output *= scale;
@@ -166,6 +228,13 @@ namespace rose::eval::nnue {
         m_stack.push_back(rebuild_accumulator(pos));
       }
 
+      // Starts from accumulators that were computed elsewhere, such as by batch evaluation.
+      auto reset(const Position& pos, const AccumulatorPair& accumulators) -> void {
+        rose_unused(pos);
+        m_stack.clear();
+        m_stack.push_back(accumulators);
+      }
+
       auto push() -> void {
         m_stack.push_back(m_stack.back());
       }
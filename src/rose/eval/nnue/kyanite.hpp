@@ -1,250 +1,137 @@
 #pragma once
 
 #include "rose/common.hpp"
-#include "rose/eval/concepts.hpp"
-#include "rose/limits.hpp"
+#include "rose/eval/nnue/feature_transformer.hpp"
 #include "rose/position.hpp"
 #include "rose/score.hpp"
-#include "rose/square.hpp"
-#include "rose/util/assert.hpp"
-#include "rose/util/static_vector.hpp"
 
+#include <algorithm>
 #include <array>
 #include <lps/lps.hpp>
 
 namespace rose::eval::nnue {
 
-  template<usize hl_size>
-  struct Kyanite {
-    inline static constexpr usize input_size = 768;
+  // (768 x buckets -> hl_size)x2 -> 1, with a squared clipped ReLU on the feature transformer output.
+  // output_buckets selects one of several output layers by the number of pieces on the board.
+  template<usize hl_size, typename FtWeight = i16, usize output_buckets = 1, typename InputBuckets = NoKingBuckets>
+  struct Kyanite : FeatureTransformer<hl_size, FtWeight, InputBuckets> {
+    using Transformer = FeatureTransformer<hl_size, FtWeight, InputBuckets>;
+    using typename Transformer::Accumulator;
+    using typename Transformer::AccumulatorPair;
+    using typename Transformer::AccumulatorStack;
+
     inline static constexpr i32 scale = 400;
     inline static constexpr i32 qa = 255;
     inline static constexpr i32 qb = 64;
 
-    inline static auto feature_index(const Position& pos, Color perspective, Square sq, PieceType ptype, Color side) -> usize {
-      //                          qrb-npk-
-      constexpr u32 ptype_lut = 0x43201050;
-
-      usize side_index = side.to_index();
-      usize ptype_index = (ptype_lut >> (4 * ptype.to_index())) & 0xf;
-      usize square_index = sq.raw ^ (pos.king_sq(perspective).file() >= 4 ? 0b000111 : 0);
-
-      if (perspective == Color::black) {
-        side_index ^= 1;
-        square_index ^= 0b111000;
+    // Same bucketing as bullet's MaterialCount output buckets.
+    inline static auto output_bucket(const Position& pos) -> usize {
+      if constexpr (output_buckets == 1) {
+        return 0;
+      } else {
+        constexpr usize divisor = (32 + output_buckets - 1) / output_buckets;
+        return static_cast<usize>(pos.board().occupied_bitboard().popcount() - 2) / divisor;
       }
-
-      return side_index * 64 * 6 + ptype_index * 64 + square_index;
     }
 
-    using Accumulator = std::array<i16, hl_size>;
-
-    struct alignas(64) AccumulatorPair {
-      std::array<Accumulator, 2> values;
-
-      const Accumulator& get(Color color) const {
-        return values[color.to_index()];
-      }
-
-      inline constexpr auto operator==(const AccumulatorPair&) const -> bool = default;
+    struct Network : Transformer::Weights {
+      std::array<std::array<Accumulator, 2>, output_buckets> output_weights;
+      std::array<i16, output_buckets> output_bias;
     };
 
-    struct Network {
-      std::array<Accumulator, input_size> accumulator_weights;
-      Accumulator accumulator_biases;
-      std::array<Accumulator, 2> output_weights;
-      i16 output_bias;
-    };
-
-    inline static auto add(const Network& net, Accumulator& acc0, usize feat0, Accumulator& acc1, usize feat1) -> void {
-      static_assert(hl_size % i16xN::size == 0);
-
-      for (usize i = 0; i < hl_size; i += i16xN::size) {
-        const i16xN w0 = i16xN::load(&net.accumulator_weights[feat0][i]);
-        const i16xN w1 = i16xN::load(&net.accumulator_weights[feat1][i]);
-        (i16xN::load(&acc0[i]) + w0).store(&acc0[i]);
-        (i16xN::load(&acc1[i]) + w1).store(&acc1[i]);
-      }
-    }
-
-    inline static auto sub(const Network& net, Accumulator& acc0, usize feat0, Accumulator& acc1, usize feat1) -> void {
-      static_assert(hl_size % i16xN::size == 0);
+    // Runtime layout of the output layer, built from the file layout when a State is constructed. Each i16xN chunk of the
+    // side-to-move weights is immediately followed by the matching chunk of the other side's weights, so that evaluate
+    // streams through a single array. The chunk width depends on the lps backend, which is why this is not the file layout.
+    struct OutputLayer {
+      alignas(64) std::array<i16, 2 * hl_size> weights;
+      i16 bias;
 
-      for (usize i = 0; i < hl_size; i += i16xN::size) {
-        const i16xN w0 = i16xN::load(&net.accumulator_weights[feat0][i]);
-        const i16xN w1 = i16xN::load(&net.accumulator_weights[feat1][i]);
-        (i16xN::load(&acc0[i]) - w0).store(&acc0[i]);
-        (i16xN::load(&acc1[i]) - w1).store(&acc1[i]);
-      }
-    }
-
-    inline static auto subadd(const Network& net, Accumulator& acc0, usize sub0, usize add0, Accumulator& acc1, usize sub1, usize add1) -> void {
-      static_assert(hl_size % i16xN::size == 0);
+      static auto from_network(const Network& net, usize bucket) -> OutputLayer {
+        static_assert(hl_size % i16xN::size == 0);
 
-      for (usize i = 0; i < hl_size; i += i16xN::size) {
-        const i16xN w_sub0 = i16xN::load(&net.accumulator_weights[sub0][i]);
-        const i16xN w_sub1 = i16xN::load(&net.accumulator_weights[sub1][i]);
-        const i16xN w_add0 = i16xN::load(&net.accumulator_weights[add0][i]);
-        const i16xN w_add1 = i16xN::load(&net.accumulator_weights[add1][i]);
-        (i16xN::load(&acc0[i]) - w_sub0 + w_add0).store(&acc0[i]);
-        (i16xN::load(&acc1[i]) - w_sub1 + w_add1).store(&acc1[i]);
+        OutputLayer result;
+        for (usize i = 0; i < hl_size; i += i16xN::size) {
+          std::copy_n(&net.output_weights[bucket][0][i], i16xN::size, &result.weights[2 * i]);
+          std::copy_n(&net.output_weights[bucket][1][i], i16xN::size, &result.weights[2 * i + i16xN::size]);
+        }
+        result.bias = net.output_bias[bucket];
+        return result;
       }
-    }
+    };
 
     inline static auto screlu(i16 x) -> i32 {
       i32 y = std::clamp<i32>(x, 0, qa);
       return y * y;
     }
 
-    inline static auto rebuild_accumulator(const Position& pos, const Network& net) -> AccumulatorPair {
-      AccumulatorPair result;
-      result.values.fill(net.accumulator_biases);
-
-      for (u8 i = 0; i < 64; i++) {
-        const Square sq {i};
-        const Place p = pos.place_at(sq);
-
-        if (p.is_empty())
-          continue;
-
-        const usize feature0 = feature_index(pos, Color::white, sq, p.ptype(), p.color());
-        const usize feature1 = feature_index(pos, Color::black, sq, p.ptype(), p.color());
-
-        add(net, result.values[0], feature0, result.values[1], feature1);
-      }
+    inline static auto evaluate(const OutputLayer& output_layer, const Accumulator& us, const Accumulator& them) -> i32 {
+      static_assert(hl_size % i16xN::size == 0);
 
-      return result;
+      i32xN output0 = i32xN::zero();
+      i32xN output1 = i32xN::zero();
+      for (usize i = 0; i < hl_size; i += i16xN::size) {
+        const i16xN w0 = i16xN::load(&output_layer.weights[2 * i]);
+        const i16xN w1 = i16xN::load(&output_layer.weights[2 * i + i16xN::size]);
+        const i16xN x0_i = i16xN::load(&us[i]);
+        const i16xN x1_i = i16xN::load(&them[i]);
+        const i16xN c0_i = x0_i.clamp(i16xN::zero(), i16xN::splat(qa));
+        const i16xN c1_i = x1_i.clamp(i16xN::zero(), i16xN::splat(qa));
+        output0 = output0.accumulate_pair_dot(w0 * c0_i, c0_i);
+        output1 = output1.accumulate_pair_dot(w1 * c1_i, c1_i);
+      }
+
+      i32 output = (output0 + output1).reduce_add();
+      output /= qa;
+      output += output_layer.bias;
+      output *= scale;
+      output /= qa * qb;
+      return output;
     }
 
-    struct Observer {
-    private:
-      const Network& m_net;
-      AccumulatorPair& m_accum;
-      bool refresh = false;
-
-    public:
-      Observer(const Network& net, AccumulatorPair& accum) :
-          m_net(net),
-          m_accum(accum) {
-      }
-
-      auto on_king_move(const Position& pos, Color stm, Square from, Square to) -> void {
-        refresh = (from.file() >= 4 && to.file() < 4) || (from.file() < 4 && to.file() >= 4);
-      }
-
-      auto on_add(const Position& pos, Color side, PieceType ptype, Square sq) -> void {
-        add(m_net,
-            m_accum.values[0],
-            feature_index(pos, Color::white, sq, ptype, side),
-            m_accum.values[1],
-            feature_index(pos, Color::black, sq, ptype, side));
-      }
-
-      auto on_remove(const Position& pos, Color side, PieceType ptype, Square sq) -> void {
-        sub(m_net,
-            m_accum.values[0],
-            feature_index(pos, Color::white, sq, ptype, side),
-            m_accum.values[1],
-            feature_index(pos, Color::black, sq, ptype, side));
-      }
-
-      auto on_mutate(const Position& pos, Color side, PieceType src_ptype, PieceType dst_ptype, Square sq) -> void {
-        subadd(m_net,
-               m_accum.values[0],
-               feature_index(pos, Color::white, sq, src_ptype, side),
-               feature_index(pos, Color::white, sq, dst_ptype, side),
-               m_accum.values[1],
-               feature_index(pos, Color::black, sq, src_ptype, side),
-               feature_index(pos, Color::black, sq, dst_ptype, side));
-      }
-
-      auto on_move(const Position& pos, Color side, PieceType ptype, Square from, Square to) -> void {
-        subadd(m_net,
-               m_accum.values[0],
-               feature_index(pos, Color::white, from, ptype, side),
-               feature_index(pos, Color::white, to, ptype, side),
-               m_accum.values[1],
-               feature_index(pos, Color::black, from, ptype, side),
-               feature_index(pos, Color::black, to, ptype, side));
-      }
-
-      auto on_promote(const Position& pos, Color side, PieceType dst_ptype, Square from, Square to) -> void {
-        subadd(m_net,
-               m_accum.values[0],
-               feature_index(pos, Color::white, from, PieceType::p, side),
-               feature_index(pos, Color::white, to, dst_ptype, side),
-               m_accum.values[1],
-               feature_index(pos, Color::black, from, PieceType::p, side),
-               feature_index(pos, Color::black, to, dst_ptype, side));
-      }
-
-      auto on_finalize(const Position& pos) -> void {
-        if (refresh) {
-          m_accum = rebuild_accumulator(pos, m_net);
-        }
+    // Architectures can share a feature transformer, but Position::move is explicitly instantiated once per architecture,
+    // so each one needs its own observer type.
+    struct Observer : Transformer::Observer {
+      explicit Observer(const Transformer::Observer& observer) :
+          Transformer::Observer(observer) {
       }
     };
 
-    static_assert(concepts::Observer<Observer>);
-
     struct State {
     private:
-      StaticVector<AccumulatorPair, max_depth + 6> m_stack;
-      const Network& m_net;
-
-      auto evaluate(const Accumulator& us, const Accumulator& them) -> i32 {
-        static_assert(hl_size % i16xN::size == 0);
-
-        i32xN output0 = i32xN::zero();
-        i32xN output1 = i32xN::zero();
-        for (usize i = 0; i < hl_size; i += i16xN::size) {
-          const i16xN w0 = i16xN::load(&m_net.output_weights[0][i]);
-          const i16xN w1 = i16xN::load(&m_net.output_weights[1][i]);
-          const i16xN x0_i = i16xN::load(&us[i]);
-          const i16xN x1_i = i16xN::load(&them[i]);
-          const i16xN c0_i = x0_i.clamp(i16xN::zero(), i16xN::splat(qa));
-          const i16xN c1_i = x1_i.clamp(i16xN::zero(), i16xN::splat(qa));
-          output0 = output0.accumulate_pair_dot(w0 * c0_i, c0_i);
-          output1 = output1.accumulate_pair_dot(w1 * c1_i, c1_i);
-        }
-
-        i32 output = (output0 + output1).reduce_add();
-        output /= qa;
-        output += m_net.output_bias;
-        output *= scale;
-        output /= qa * qb;
-        return output;
-      }
+      AccumulatorStack m_accumulators;
+      std::array<OutputLayer, output_buckets> m_output_layers;
 
     public:
       explicit State(const Network& net) :
-          m_net(net) {
+          m_accumulators(net) {
+        for (usize bucket = 0; bucket < output_buckets; bucket++)
+          m_output_layers[bucket] = OutputLayer::from_network(net, bucket);
       }
 
       auto reset(const Position& pos) -> void {
-        m_stack.clear();
-        m_stack.push_back(rebuild_accumulator(pos, m_net));
+        m_accumulators.reset(pos);
+      }
+
+      auto reset(const Position& pos, const AccumulatorPair& accumulators) -> void {
+        m_accumulators.reset(pos, accumulators);
       }
 
       auto push() -> void {
-        m_stack.push_back(m_stack.back());
+        m_accumulators.push();
       }
 
       auto pop() -> void {
-        m_stack.pop_back();
+        m_accumulators.pop();
       }
 
       auto evaluate(const Position& pos) -> Score {
         const Color stm = pos.stm();
-        const AccumulatorPair& accumulators = m_stack.back();
-
-        rose_assert(rebuild_accumulator(pos, m_net) == accumulators);
-
-        return evaluate(accumulators.get(stm), accumulators.get(stm.invert()));
+        const AccumulatorPair& accumulators = m_accumulators.get(pos);
+        return Kyanite::evaluate(m_output_layers[output_bucket(pos)], accumulators.get(stm), accumulators.get(stm.invert()));
       }
 
       auto observer() -> Observer {
-        return Observer {m_net, m_stack.back()};
+        return Observer {m_accumulators.observer()};
       }
     };
   };
@@ -0,0 +1,46 @@
+#include "rose/eval/nnue/network.hpp"
+
+#include "rose/common.hpp"
+#include "rose/eval/nnue/container.hpp"
+#include "rose/eval/nnue/embedded.hpp"
+#include "rose/util/mapped_file.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <expected>
+#include <fmt/format.h>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace rose::eval::nnue {
+
+  auto LoadedNetwork::from_container(std::span<const std::byte> bytes, std::shared_ptr<const void> storage)
+    -> std::expected<LoadedNetwork, NetworkError> {
+    const auto parsed = container::parse(bytes);
+    if (!parsed)
+      return std::unexpected(parsed.error());
+
+    const auto [arch, payload] = *parsed;
+    return LoadedNetwork {std::move(storage), payload.data(), arch};
+  }
+
+  auto LoadedNetwork::embedded() -> LoadedNetwork {
+    static const auto network = from_container({reinterpret_cast<const std::byte*>(&g_embedded_network_raw[0]), g_embedded_network_size}, nullptr);
+    if (!network) [[unlikely]] {
+      fmt::print(stderr, "Embedded network rejected: {}\n", network.error());
+      std::exit(1);
+    }
+    return *network;
+  }
+
+  auto LoadedNetwork::load(const std::string& path) -> std::expected<LoadedNetwork, NetworkError> {
+    std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+    if (!file)
+      return std::unexpected(NetworkError::open_failed);
+
+    const std::span<const std::byte> bytes = file->bytes();
+    return from_container(bytes, std::move(file));
+  }
+
+}  // namespace rose::eval::nnue
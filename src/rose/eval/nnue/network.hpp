@@ -0,0 +1,103 @@
+#pragma once
+
+#include "rose/common.hpp"
+#include "rose/eval/nnue/arch.hpp"
+#include "rose/util/assert.hpp"
+
+#include <cstddef>
+#include <expected>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+
+namespace rose::eval::nnue {
+
+  enum class NetworkError {
+    open_failed,
+    too_small,
+    bad_magic,
+    unsupported_version,
+    unknown_arch,
+    hidden_size_mismatch,
+    quantisation_mismatch,
+    payload_size_mismatch,
+    checksum_mismatch,
+  };
+
+  // A verified network of any registered architecture, backed either by the embedded network or by a memory-mapped file.
+  struct LoadedNetwork {
+  private:
+    std::shared_ptr<const void> m_storage;
+    const std::byte* m_weights;
+    ArchId m_arch;
+
+    LoadedNetwork(std::shared_ptr<const void> storage, const std::byte* weights, ArchId arch) :
+        m_storage(std::move(storage)),
+        m_weights(weights),
+        m_arch(arch) {
+    }
+
+    static auto from_container(std::span<const std::byte> bytes, std::shared_ptr<const void> storage) -> std::expected<LoadedNetwork, NetworkError>;
+
+  public:
+    static auto embedded() -> LoadedNetwork;
+    static auto load(const std::string& path) -> std::expected<LoadedNetwork, NetworkError>;
+
+    auto arch() const -> ArchId {
+      return m_arch;
+    }
+
+    auto is_embedded() const -> bool {
+      return m_storage == nullptr;
+    }
+
+    template<typename Arch>
+    auto get() const -> const Arch::Network& {
+      rose_assert(arch_id_of<Arch>() == m_arch);
+      return *reinterpret_cast<const Arch::Network*>(m_weights);
+    }
+
+    // Calls f.template operator()<Arch>(network) with the concrete architecture of this network.
+    template<typename F>
+    auto visit(F&& f) const -> decltype(auto) {
+      return visit_arch(m_arch, [&]<typename Arch>() -> decltype(auto) {
+        return f.template operator()<Arch>(get<Arch>());
+      });
+    }
+  };
+
+}  // namespace rose::eval::nnue
+
+template<>
+struct fmt::formatter<rose::eval::nnue::NetworkError, char> {
+  template<class ParseContext>
+  constexpr auto parse(ParseContext& ctx) -> ParseContext::iterator {
+    return ctx.begin();
+  }
+
+  template<class FmtContext>
+  auto format(rose::eval::nnue::NetworkError err, FmtContext& ctx) const -> FmtContext::iterator {
+    switch (err) {
+    case rose::eval::nnue::NetworkError::open_failed:
+      return fmt::format_to(ctx.out(), "Could Not Open File");
+    case rose::eval::nnue::NetworkError::too_small:
+      return fmt::format_to(ctx.out(), "File Too Small");
+    case rose::eval::nnue::NetworkError::bad_magic:
+      return fmt::format_to(ctx.out(), "Not A Rosenet Container");
+    case rose::eval::nnue::NetworkError::unsupported_version:
+      return fmt::format_to(ctx.out(), "Unsupported Container Version");
+    case rose::eval::nnue::NetworkError::unknown_arch:
+      return fmt::format_to(ctx.out(), "Unknown Architecture");
+    case rose::eval::nnue::NetworkError::hidden_size_mismatch:
+      return fmt::format_to(ctx.out(), "Hidden Size Mismatch");
+    case rose::eval::nnue::NetworkError::quantisation_mismatch:
+      return fmt::format_to(ctx.out(), "Quantisation Constants Mismatch");
+    case rose::eval::nnue::NetworkError::payload_size_mismatch:
+      return fmt::format_to(ctx.out(), "Payload Size Mismatch");
+    case rose::eval::nnue::NetworkError::checksum_mismatch:
+      return fmt::format_to(ctx.out(), "Checksum Mismatch");
+    }
+    std::unreachable();
+  }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "rose/common.hpp"
+#include "rose/hash.hpp"
+#include "rose/score.hpp"
+
+#include <array>
+#include <bit>
+#include <optional>
+
+namespace rose {
+
+  // Small per-thread, direct-mapped cache of raw static evaluations keyed by the full position hash. It catches
+  // transpositions whose raw eval has been lost from the shared TT, saving a network evaluation.
+  struct EvalCache {
+  private:
+    inline static constexpr usize entry_count = 16384;
+    static_assert(std::has_single_bit(entry_count));
+
+    struct Entry {
+      u32 key = 0;
+      Score raw_eval = score::none;
+    };
+
+    std::array<Entry, entry_count> m_entries {};
+
+    static auto index(Hash hash) -> usize {
+      return static_cast<usize>(hash) & (entry_count - 1);
+    }
+
+    static auto key(Hash hash) -> u32 {
+      return static_cast<u32>(hash >> 32);
+    }
+
+  public:
+    auto load(Hash hash) const -> std::optional<Score> {
+      const Entry& entry = m_entries[index(hash)];
+      if (entry.key != key(hash) || entry.raw_eval == score::none)
+        return std::nullopt;
+      return entry.raw_eval;
+    }
+
+    auto store(Hash hash, Score raw_eval) -> void {
+      m_entries[index(hash)] = Entry {key(hash), raw_eval};
+    }
+  };
+
+}  // namespace rose
@@ -59,8 +59,9 @@ namespace rose {
 
     auto move(Move m) -> void {
       m_move_stack.push_back(m);
-      m_hash_stack.push_back(m_position_stack.back().hashes_after(m_hash_stack.back(), m));
-      m_position_stack.emplace_back(m_position_stack.back().move(m));
+      Hashes hashes = m_hash_stack.back();
+      m_position_stack.emplace_back(m_position_stack.back().move(m, hashes));
+      m_hash_stack.push_back(hashes);
     }
 
     auto unmove() -> void {
@@ -74,6 +74,21 @@ namespace rose::geometry {
 
   }  // namespace internal
 
+  // Byte i of the result is set if bit i of bits is. lps builds AVX2 vector masks from bits one element at a time.
+  inline auto bits_to_mask(u64 bits) -> m8x64 {
+#if LPS_AVX2
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,  //
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const u8x64 select = std::bit_cast<u8x64>(u64x8::splat(0x8040201008040201));
+    u8x64 y;
+    y.raw[0].raw = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<i32>(bits)), spread);
+    y.raw[1].raw = _mm256_shuffle_epi8(_mm256_set1_epi32(static_cast<i32>(bits >> 32)), spread);
+    return (y & select).eq(select);
+#else
+    return m8x64 {bits};
+#endif
+  }
+
   inline auto superpiece_rays(Square sq) -> std::tuple<u8x64, m8x64> {
     constexpr u8x64 offsets {{
       0x1F, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70,  // north
@@ -2,10 +2,13 @@
 
 #include "fmt/base.h"
 #include "rose/cmd/bench.hpp"
+#include "rose/cmd/evalbench.hpp"
 #include "rose/cmd/perft.hpp"
+#include "rose/cmd/perftbench.hpp"
 #include "rose/common.hpp"
 #include "rose/engine_output_uci.hpp"
 #include "rose/engine_output_xboard.hpp"
+#include "rose/eval/nnue/network.hpp"
 #include "rose/position.hpp"
 #include "rose/search.hpp"
 #include "rose/tt.hpp"
@@ -105,6 +108,10 @@ namespace rose {
       uci_perft(it);
     } else if (cmd == "bench") {
       uci_bench(it);
+    } else if (cmd == "evalbench") {
+      uci_evalbench(it);
+    } else if (cmd == "perftbench") {
+      uci_perftbench(it);
     } else if (cmd == "moves") {
       uci_moves(it);
     } else if (cmd == "d") {
@@ -217,11 +224,12 @@ namespace rose {
   }
 
   auto Interface::uci_uci(Tokenizer&) -> void {
-    fmt::print("id name Rose {}\n", rose::version::to_string());
+    fmt::print("id name Rose {} ({})\n", rose::version::to_string(), rose::version::simd_environment);
     fmt::print("id author 87 (87flowers.com)\n");
     fmt::print("option name Hash type spin default {} min 1 max {}\n", tt::default_hash_size_mb, tt::maximum_hash_size_mb);
     fmt::print("option name Threads type spin default 1 min 1 max {}\n", max_threads);
     fmt::print("option name UCI_Chess960 type check default false\n");
+    fmt::print("option name EvalFile type string default <embedded>\n");
     tune::uci_print_options();
     fmt::print("uciok\n");
   }
@@ -237,6 +245,7 @@ namespace rose {
 
     if (!expect_token("setoption", it, "value"))
       return;
+    const std::string_view value_line = it.rest();
     const std::string_view value = it.next();
 
     if (name == "Hash") {
@@ -257,6 +266,18 @@ namespace rose {
       } else {
         return print_unrecognised_token("setoption", value);
       }
+    } else if (name == "EvalFile") {
+      // Paths may contain spaces, so take the remainder of the line rather than a single token.
+      const std::string_view path = value_line.substr(0, value_line.find_last_not_of(" \t\r\n\f\v") + 1);
+      if (path == "<embedded>") {
+        m_engine.set_network(eval::nnue::LoadedNetwork::embedded());
+        return;
+      }
+      auto network = eval::nnue::LoadedNetwork::load(std::string {path});
+      if (!network)
+        return print_protocol_error("setoption", "could not load network `{}`: {}", path, network.error());
+      fmt::print("info string loaded {} network from {}\n", network->arch(), path);
+      m_engine.set_network(std::move(*network));
     } else if (tune::uci_parse_option(name, value)) {
       return;
     } else {
@@ -274,22 +295,47 @@ namespace rose {
     if (!depth || *depth < 0)
       return print_unrecognised_token("perft", depth_str);
 
-    const std::string_view bulk_str = it.rest().empty() ? "bulk" : it.next();
-    bool bulk;
-    if (bulk_str == "bulk")
-      bulk = true;
-    else if (bulk_str == "nonbulk" || bulk_str == "nobulk")
-      bulk = false;
-    else
-      return print_unrecognised_token("perft", bulk_str);
+    perft::Options options;
+    while (true) {
+      const std::string_view part = it.next();
+      if (part.empty()) {
+        break;
+      } else if (part == "bulk") {
+        options.bulk = true;
+      } else if (part == "nonbulk" || part == "nobulk") {
+        options.bulk = false;
+      } else if (part == "threads") {
+        const std::string_view value = it.next();
+        const auto threads = parse_int(value);
+        if (!threads || *threads <= 0 || *threads > static_cast<int>(max_threads))
+          return print_unrecognised_token("perft", value);
+        options.threads = static_cast<usize>(*threads);
+      } else if (part == "hash") {
+        const std::string_view value = it.next();
+        const auto hash = parse_int(value);
+        if (!hash || *hash < 0 || *hash > static_cast<int>(tt::maximum_hash_size_mb))
+          return print_unrecognised_token("perft", value);
+        options.hash_mb = static_cast<usize>(*hash);
+      } else {
+        return print_unrecognised_token("perft", part);
+      }
+    }
 
-    perft::run(m_game.position(), static_cast<usize>(*depth), bulk);
+    perft::run(m_game.position(), static_cast<usize>(*depth), options);
   }
 
   auto Interface::uci_bench(Tokenizer&) -> void {
     bench::run();
   }
 
+  auto Interface::uci_evalbench(Tokenizer&) -> void {
+    evalbench::run();
+  }
+
+  auto Interface::uci_perftbench(Tokenizer&) -> void {
+    perftbench::run();
+  }
+
   auto Interface::uci_moves(Tokenizer& it) -> void {
     while (true) {
       const std::string_view move_str = it.next();
@@ -48,6 +48,8 @@ namespace rose {
     auto uci_stop(Tokenizer& it) -> void;
     auto uci_perft(Tokenizer& it) -> void;
     auto uci_bench(Tokenizer& it) -> void;
+    auto uci_evalbench(Tokenizer& it) -> void;
+    auto uci_perftbench(Tokenizer& it) -> void;
     auto uci_moves(Tokenizer& it) -> void;
 
     auto xboard_parse_command(std::string_view line, time::TimePoint start_time) -> void;
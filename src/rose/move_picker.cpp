@@ -9,14 +9,15 @@
 
 #include <algorithm>
 #include <ranges>
+#include <utility>
 
 namespace rose {
 
-  MovePicker::MovePicker(const SearchData& sd, const Position& position, const SearchStack* ss, Move hint_move) :
+  MovePicker::MovePicker(const SearchData& sd, const Position& position, const PinInfo& pin_info, const SearchStack* ss, Move hint_move) :
       m_sd(sd),
       m_position(position),
       m_ss(ss),
-      m_movegen(position),
+      m_movegen(position, pin_info),
       m_hint_move(hint_move) {
   }
 
@@ -39,8 +40,8 @@ namespace rose {
       [[fallthrough]];
     case Stage::emit_good_noisy:
       while (m_current_index < m_moves.size()) {
-        const Move mv = m_moves[m_current_index++];
-        if (!see::see(m_position, mv, -163_z)) {
+        const Move mv = pick_best();
+        if (!m_exchanges.see(m_position, mv, -163_z)) {
           m_bad_noisies.push_back(mv);
           continue;
         }
@@ -68,7 +69,7 @@ namespace rose {
       [[fallthrough]];
     case Stage::emit_quiet:
       while (m_current_index < m_moves.size()) {
-        const Move mv = m_moves[m_current_index++];
+        const Move mv = pick_best();
         if (mv == m_hint_move)
           continue;
         return mv;
@@ -96,12 +97,30 @@ namespace rose {
     }
   }
 
+  auto MovePicker::pick_best() -> Move {
+    if (m_current_index < selection_picks) {
+      usize best = m_current_index;
+      for (usize i = m_current_index + 1; i < m_moves.size(); i++) {
+        if (m_scores[i] > m_scores[best])
+          best = i;
+      }
+
+      std::swap(m_moves[m_current_index], m_moves[best]);
+      std::swap(m_scores[m_current_index], m_scores[best]);
+    } else if (m_current_index == selection_picks) {
+      std::ranges::sort(std::ranges::zip_view(m_moves, m_scores) | std::views::drop(m_current_index), [](auto&& a, auto&& b) {
+        return std::get<1>(a) > std::get<1>(b);
+      });
+    }
+
+    return m_moves[m_current_index++];
+  }
+
   auto MovePicker::generate_noisy() -> void {
     m_moves.clear();
     m_movegen.generate_noisy(m_moves);
 
-    StaticVector<i32, max_legal_moves> scores;
-    scores.resize(m_moves.size());
+    m_scores.resize(m_moves.size());
 
     const Color stm = m_position.stm();
 
@@ -116,20 +135,15 @@ namespace rose {
       score += victim_score[victim.to_index()] * 7_z;
       score += m_sd.noisy_history.get(stm, attacker, mv);
 
-      scores[i] = score * 256 - i;
+      m_scores[i] = score * 256 - i;
     }
-
-    std::ranges::sort(std::ranges::zip_view(m_moves, scores), [](auto&& a, auto&& b) {
-      return std::get<1>(a) > std::get<1>(b);
-    });
   }
 
   auto MovePicker::generate_quiet() -> void {
     m_moves.clear();
     m_movegen.generate_quiet(m_moves);
 
-    StaticVector<i32, max_legal_moves> scores;
-    scores.resize(m_moves.size());
+    m_scores.resize(m_moves.size());
 
     const Color stm = m_position.stm();
     const Bitboard threats = m_position.attack_table(!stm).bitboard_any();
@@ -144,12 +158,8 @@ namespace rose {
         if (m_ss[-i].conthist)
           score += m_ss[-i].conthist->get(stm, ptype, mv);
 
-      scores[i] = score * 256 - i;
+      m_scores[i] = score * 256 - i;
     }
-
-    std::ranges::sort(std::ranges::zip_view(m_moves, scores), [](auto&& a, auto&& b) {
-      return std::get<1>(a) > std::get<1>(b);
-    });
   }
 
 }  // namespace rose
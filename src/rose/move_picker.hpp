@@ -4,6 +4,8 @@
 #include "rose/move.hpp"
 #include "rose/movegen.hpp"
 #include "rose/search.hpp"
+#include "rose/see.hpp"
+#include "rose/util/static_vector.hpp"
 
 namespace rose {
 
@@ -36,14 +38,23 @@ namespace rose {
     bool m_skip_quiet = false;
     usize m_current_index = 0;
     MoveList m_moves;
+    StaticVector<i32, max_legal_moves> m_scores;
     MoveList m_bad_noisies;
+    see::ExchangeCache m_exchanges;
+    see::SafetyMap m_safety;
 
   public:
     // SAFETY: hint_move must be legal
-    MovePicker(const SearchData& sd, const Position& position, const SearchStack* ss, Move hint_move);
+    MovePicker(const SearchData& sd, const Position& position, const PinInfo& pin_info, const SearchStack* ss, Move hint_move);
 
     auto next() -> Move;
 
+    // As see::see. Noisy moves share the extracted rays with the SEE checks the picker itself does on the same square, and
+    // quiet moves are mostly decided by the node's safety map.
+    auto see(Move mv, Score threshold) -> bool {
+      return mv.is_noisy() ? m_exchanges.see(m_position, mv, threshold) : m_safety.see(m_position, mv, threshold);
+    }
+
     auto skip_quiet() -> void {
       m_skip_quiet = true;
       if (is_in_quiet_stage()) {
@@ -53,6 +64,11 @@ namespace rose {
     }
 
   private:
+    // Most nodes cut off after the first few moves, so those are found by selection. A node that gets further is likely to
+    // search the whole list, and the rest of it is sorted in one go.
+    inline static constexpr usize selection_picks = 3;
+
+    auto pick_best() -> Move;
     auto generate_noisy() -> void;
     auto generate_quiet() -> void;
   };
@@ -8,10 +8,49 @@
 #include "rose/rays.hpp"
 #include "rose/util/static_vector.hpp"
 
+#include <array>
 #include <bit>
 
 namespace rose {
 
+#if LPS_AVX2 || LPS_SSE4_2
+  // pshufb controls that move the selected lanes of a 16-byte chunk to the front, indexed by the chunk's lane mask.
+  // lps has no compress outside of AVX-512.
+  template<usize lane_bytes>
+  alignas(16) static constexpr auto left_pack_table = [] consteval {
+    constexpr usize lanes = 16 / lane_bytes;
+    std::array<std::array<u8, 16>, 1 << lanes> table {};
+    for (usize mask = 0; mask < table.size(); mask++) {
+      usize k = 0;
+      for (usize i = 0; i < lanes; i++) {
+        if ((mask >> i) & 1) {
+          for (usize b = 0; b < lane_bytes; b++)
+            table[mask][k * lane_bytes + b] = static_cast<u8>(i * lane_bytes + b);
+          k++;
+        }
+      }
+      for (usize j = k * lane_bytes; j < 16; j++)
+        table[mask][j] = 0x80;
+    }
+    return table;
+  }();
+
+  // Stores the lanes of v selected by mask contiguously at out, one 16-byte chunk at a time. Each chunk store writes a
+  // full 16 bytes; the capacity slack of MoveList covers the overhang.
+  template<usize lane_bytes, typename T>
+  static inline auto left_pack(Move* out, u64 mask, T v) -> void {
+    constexpr usize lanes = 16 / lane_bytes;
+    constexpr u64 chunk_mask = (u64 {1} << lanes) - 1;
+    const auto chunks = std::bit_cast<std::array<__m128i, sizeof(T) / 16>>(v);
+    for (usize c = 0; c < chunks.size(); c++) {
+      const u64 m = (mask >> (c * lanes)) & chunk_mask;
+      const __m128i control = _mm_load_si128(reinterpret_cast<const __m128i*>(left_pack_table<lane_bytes>[m].data()));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(chunks[c], control));
+      out += std::popcount(m) * (lane_bytes / sizeof(Move));
+    }
+  }
+#endif
+
   template<typename M, typename T>
   auto MoveList::write(M mask, T v) -> void {
     const usize count = std::popcount(mask);
@@ -21,6 +60,8 @@ namespace rose {
     using BM = lps::environment::bit_mask<u16, T::size>;
     const V y = BM {mask}.compress(std::bit_cast<V>(v));
     std::memcpy(data.data() + len, &y, sizeof(V));
+#elif LPS_AVX2 || LPS_SSE4_2
+    left_pack<2>(data.data() + len, mask, v);
 #else
     for (int i = 0; i < count; i++, mask &= mask - 1)
       std::memcpy(data.data() + len + i, reinterpret_cast<char*>(&v.raw) + std::countr_zero(mask) * sizeof(u16), sizeof(u16));
@@ -37,6 +78,8 @@ namespace rose {
     using BM = lps::environment::bit_mask<u32, T::size / 2>;
     const V y = BM {mask}.compress(std::bit_cast<V>(v));
     std::memcpy(data.data() + len, &y, sizeof(V));
+#elif LPS_AVX2 || LPS_SSE4_2
+    left_pack<4>(data.data() + len, mask, v);
 #else
     for (int i = 0; i < count; i++, mask &= mask - 1)
       std::memcpy(data.data() + len + i * 2, reinterpret_cast<char*>(&v.raw) + std::countr_zero(mask) * sizeof(u16) * 2, sizeof(u16) * 2);
@@ -53,6 +96,8 @@ namespace rose {
     using BM = lps::environment::bit_mask<u64, T::size / 4>;
     const V y = BM {mask}.compress(std::bit_cast<V>(v));
     std::memcpy(data.data() + len, &y, sizeof(V));
+#elif LPS_AVX2 || LPS_SSE4_2
+    left_pack<8>(data.data() + len, mask, v);
 #else
     for (int i = 0; i < count; i++, mask &= mask - 1)
       std::memcpy(data.data() + len + i * 4, reinterpret_cast<char*>(&v.raw) + std::countr_zero(mask) * sizeof(u16) * 4, sizeof(u16) * 4);
@@ -60,8 +105,8 @@ namespace rose {
     len += count * 4;
   }
 
-  template<MoveFlags mf>
-  auto MoveGen::write_moves(MoveList& moves, const std::array<PieceMask, 64>& at, u16x16 srcs, Bitboard bb, PieceMask pm) -> void {
+  template<MoveFlags mf, typename Moves>
+  auto MoveGen::write_moves(Moves& moves, const std::array<PieceMask, 64>& at, u16x16 srcs, Bitboard bb, PieceMask pm) -> void {
     for (Square to : bb) {
       const PieceMask mask = pm & at[to.raw];
       const u16x16 dest = u16x16::splat(static_cast<u16>(mf) | (static_cast<u16>(to.raw) << 6));
@@ -69,8 +114,8 @@ namespace rose {
     }
   }
 
-  template<MoveFlags mf>
-  auto MoveGen::write_moves(MoveList& moves, Square from, Bitboard to_bb) -> void {
+  template<MoveFlags mf, typename Moves>
+  auto MoveGen::write_moves(Moves& moves, Square from, Bitboard to_bb) -> void {
     constexpr std::array<u16x32, 2> base = [] consteval {
       std::array<Move, 64> base;
       for (u8 i = 0; i < 64; i++) {
@@ -82,7 +127,8 @@ namespace rose {
     moves.write(static_cast<u32>(to_bb.raw >> 32), base[1] | u16x32::splat(from.raw));
   }
 
-  auto MoveGen::write_cap_promo(MoveList& moves, const std::array<PieceMask, 64>& at, Bitboard bb, PieceMask pm) -> void {
+  template<typename Moves>
+  auto MoveGen::write_cap_promo(Moves& moves, const std::array<PieceMask, 64>& at, Bitboard bb, PieceMask pm) -> void {
     const Color stm = m_position.stm();
     for (Square to : bb) {
       const PieceMask mask = pm & at[to.raw];
@@ -96,15 +142,15 @@ namespace rose {
     }
   }
 
-  template<bool in_check, MoveGen::Mode mode>
-  auto MoveGen::generate_moves_to(MoveList& moves, Square king_sq, Bitboard valid_destinations, PieceType one_checker) -> void {
+  template<bool in_check, MoveGen::Mode mode, typename Moves>
+  auto MoveGen::generate_moves_to(Moves& moves, Square king_sq, Bitboard valid_destinations, PieceType one_checker) -> void {
     const Position& position = m_position;
     const Color stm = position.stm();
 
     const Bitboard empty = position.board().empty_bitboard();
     const Bitboard enemy = position.board().color_bitboard(!stm);
 
-    const auto [at, pinned] = m_position.pin_info();
+    const auto& [at, pinned] = m_pin_info;
 
     const PieceMask king_mask = PieceMask::king();
     const PieceMask pawn_mask = position.piece_mask_for<PieceType::p>(stm);
@@ -159,9 +205,9 @@ namespace rose {
         const Square rook_hside = position.rook_info().hside(stm);
         const Square rook_aside = position.rook_info().aside(stm);
 
-        if (rook_aside.is_valid() && m_position.is_castle_aside_legal())
+        if (rook_aside.is_valid() && m_position.is_castle_aside_legal(m_pin_info))
           moves.push_back(Move::make(king_sq, rook_aside, MoveFlags::castle_aside));
-        if (rook_hside.is_valid() && m_position.is_castle_hside_legal())
+        if (rook_hside.is_valid() && m_position.is_castle_hside_legal(m_pin_info))
           moves.push_back(Move::make(king_sq, rook_hside, MoveFlags::castle_hside));
       }
       // Non-pawn quiets
@@ -210,8 +256,8 @@ namespace rose {
     }
   }
 
-  template<MoveGen::Mode mode>
-  auto MoveGen::generate_king_moves_with_checkers(MoveList& moves, Square king_sq, PieceMask checkers) -> void {
+  template<MoveGen::Mode mode, typename Moves>
+  auto MoveGen::generate_king_moves_with_checkers(Moves& moves, Square king_sq, PieceMask checkers) -> void {
     const Color stm = m_position.stm();
 
     const Bitboard valid_destinations = [&] {
@@ -242,13 +288,13 @@ namespace rose {
       write_moves<MoveFlags::normal>(moves, king_sq, active & empty & ~danger);
   }
 
-  template<MoveGen::Mode mode>
-  auto MoveGen::generate_moves_no_checkers(MoveList& moves, Square king_sq) -> void {
+  template<MoveGen::Mode mode, typename Moves>
+  auto MoveGen::generate_moves_no_checkers(Moves& moves, Square king_sq) -> void {
     generate_moves_to<false, mode>(moves, king_sq, ~Bitboard {}, PieceType::none);
   }
 
-  template<MoveGen::Mode mode>
-  auto MoveGen::generate_moves_one_checker(MoveList& moves, Square king_sq, PieceMask checkers) -> void {
+  template<MoveGen::Mode mode, typename Moves>
+  auto MoveGen::generate_moves_one_checker(Moves& moves, Square king_sq, PieceMask checkers) -> void {
     const PieceType checker_ptype = m_position.piece_list_type(!m_position.stm())[checkers.lsb()];
     const Square checker_sq = m_position.piece_list_sq(!m_position.stm())[checkers.lsb()];
     const Bitboard valid_destinations = checker_ptype == PieceType::n ? checker_sq.to_bitboard() : rays::calc_ray_to(king_sq, checker_sq);
@@ -256,17 +302,18 @@ namespace rose {
     generate_king_moves_with_checkers<mode>(moves, king_sq, checkers);
   }
 
-  template<MoveGen::Mode mode>
-  auto MoveGen::generate_moves_two_checkers(MoveList& moves, Square king_sq, PieceMask checkers) -> void {
+  template<MoveGen::Mode mode, typename Moves>
+  auto MoveGen::generate_moves_two_checkers(Moves& moves, Square king_sq, PieceMask checkers) -> void {
     generate_king_moves_with_checkers<mode>(moves, king_sq, checkers);
   }
 
-  MoveGen::MoveGen(const Position& position) :
-      m_position(position) {
+  MoveGen::MoveGen(const Position& position, const PinInfo& pin_info) :
+      m_position(position),
+      m_pin_info(pin_info) {
   }
 
-  template<MoveGen::Mode mode>
-  auto MoveGen::generate_moves(MoveList& moves) -> void {
+  template<MoveGen::Mode mode, typename Moves>
+  auto MoveGen::generate_moves(Moves& moves) -> void {
     const Color stm = m_position.stm();
     const Square king_sq = m_position.king_sq(stm);
     const PieceMask checkers = m_position.attack_table(!stm).read(king_sq);
@@ -283,5 +330,6 @@ namespace rose {
   template auto MoveGen::generate_moves<MoveGen::Mode::all>(MoveList& moves) -> void;
   template auto MoveGen::generate_moves<MoveGen::Mode::noisy>(MoveList& moves) -> void;
   template auto MoveGen::generate_moves<MoveGen::Mode::quiet>(MoveList& moves) -> void;
+  template auto MoveGen::generate_moves<MoveGen::Mode::all>(MoveCount& moves) -> void;
 
 }  // namespace rose
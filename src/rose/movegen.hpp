@@ -6,6 +6,8 @@
 #include "rose/position.hpp"
 #include "rose/util/static_vector.hpp"
 
+#include <bit>
+
 namespace rose {
 
   struct MoveList : StaticVector<Move, max_legal_moves> {
@@ -17,9 +19,31 @@ namespace rose {
     auto write4(M mask, T v) -> void;
   };
 
+  // Takes the place of a MoveList when only the number of legal moves is needed, so that no Moves are materialised.
+  struct MoveCount {
+    usize value = 0;
+
+    template<typename M, typename T>
+    auto write(M mask, T) -> void {
+      value += std::popcount(mask);
+    }
+    template<typename M, typename T>
+    auto write2(M mask, T) -> void {
+      value += std::popcount(mask) * 2;
+    }
+    template<typename M, typename T>
+    auto write4(M mask, T) -> void {
+      value += std::popcount(mask) * 4;
+    }
+    auto push_back(Move) -> void {
+      value++;
+    }
+  };
+
   struct MoveGen {
   private:
     const Position& m_position;
+    const PinInfo& m_pin_info;
 
     enum class Mode {
       all,
@@ -27,29 +51,30 @@ namespace rose {
       quiet,
     };
 
-    template<MoveFlags mf>
-    auto write_moves(MoveList& moves, const std::array<PieceMask, 64>& at, u16x16 srcs, Bitboard bb, PieceMask pm) -> void;
-    template<MoveFlags mf>
-    auto write_moves(MoveList& moves, Square from, Bitboard to_bb) -> void;
-    auto write_cap_promo(MoveList& moves, const std::array<PieceMask, 64>& at, Bitboard bb, PieceMask pm) -> void;
+    template<MoveFlags mf, typename Moves>
+    auto write_moves(Moves& moves, const std::array<PieceMask, 64>& at, u16x16 srcs, Bitboard bb, PieceMask pm) -> void;
+    template<MoveFlags mf, typename Moves>
+    auto write_moves(Moves& moves, Square from, Bitboard to_bb) -> void;
+    template<typename Moves>
+    auto write_cap_promo(Moves& moves, const std::array<PieceMask, 64>& at, Bitboard bb, PieceMask pm) -> void;
 
-    template<bool in_check, Mode mode>
-    auto generate_moves_to(MoveList& moves, Square king_sq, Bitboard valid_destinations, PieceType one_checker) -> void;
-    template<Mode mode>
-    auto generate_king_moves_with_checkers(MoveList& moves, Square king_sq, PieceMask checkers) -> void;
+    template<bool in_check, Mode mode, typename Moves>
+    auto generate_moves_to(Moves& moves, Square king_sq, Bitboard valid_destinations, PieceType one_checker) -> void;
+    template<Mode mode, typename Moves>
+    auto generate_king_moves_with_checkers(Moves& moves, Square king_sq, PieceMask checkers) -> void;
 
-    template<Mode mode>
-    auto generate_moves_no_checkers(MoveList& moves, Square king_sq) -> void;
-    template<Mode mode>
-    auto generate_moves_one_checker(MoveList& moves, Square king_sq, PieceMask checkers) -> void;
-    template<Mode mode>
-    auto generate_moves_two_checkers(MoveList& moves, Square king_sq, PieceMask checkers) -> void;
+    template<Mode mode, typename Moves>
+    auto generate_moves_no_checkers(Moves& moves, Square king_sq) -> void;
+    template<Mode mode, typename Moves>
+    auto generate_moves_one_checker(Moves& moves, Square king_sq, PieceMask checkers) -> void;
+    template<Mode mode, typename Moves>
+    auto generate_moves_two_checkers(Moves& moves, Square king_sq, PieceMask checkers) -> void;
 
-    template<Mode mode>
-    auto generate_moves(MoveList& moves) -> void;
+    template<Mode mode, typename Moves>
+    auto generate_moves(Moves& moves) -> void;
 
   public:
-    explicit MoveGen(const Position& position);
+    MoveGen(const Position& position, const PinInfo& pin_info);
 
     auto generate_all(MoveList& moves) -> void {
       generate_moves<Mode::all>(moves);
@@ -62,13 +87,26 @@ namespace rose {
     auto generate_quiet(MoveList& moves) -> void {
       generate_moves<Mode::quiet>(moves);
     }
+
+    auto count_all() -> usize {
+      MoveCount count;
+      generate_moves<Mode::all>(count);
+      return count.value;
+    }
   };
 
   inline auto generate_all_moves(const Position& position) -> MoveList {
     MoveList moves;
-    MoveGen movegen {position};
+    const PinInfo pin_info = position.calc_pin_info();
+    MoveGen movegen {position, pin_info};
     movegen.generate_all(moves);
     return moves;
   }
 
+  inline auto count_legal_moves(const Position& position) -> usize {
+    const PinInfo pin_info = position.calc_pin_info();
+    MoveGen movegen {position, pin_info};
+    return movegen.count_all();
+  }
+
 }  // namespace rose
@@ -23,13 +23,13 @@ namespace rose {
     return a.raw > b.raw ? Bitboard {(a.to_bitboard().raw << 1) - b.to_bitboard().raw} : Bitboard {(b.to_bitboard().raw << 1) - a.to_bitboard().raw};
   }
 
-  static inline auto is_castle_legal(const Position& pos, Square rook, i8 rook_dest, i8 king_dest) -> bool {
+  static inline auto is_castle_legal(const Position& pos, const PinInfo& pin_info, Square rook, i8 rook_dest, i8 king_dest) -> bool {
     const Color stm = pos.stm();
     const Square king = pos.king_sq(stm);
 
     const Bitboard empty = pos.board().empty_bitboard();
     const Bitboard danger = pos.attack_table(!stm).bitboard_any();
-    const auto [_, pinned] = pos.pin_info();
+    const Bitboard pinned = pin_info.pinned;
 
     const Bitboard king_bb = king.to_bitboard();
     const Bitboard rook_bb = rook.to_bitboard();
@@ -49,9 +49,27 @@ namespace rose {
   }
 #endif
 
+#if LPS_AVX2
+  // Interleaves the bytes of a and b into words, like concat(a.zip_low(b), a.zip_high(b)). lps implements zip_low and
+  // zip_high element by element on AVX2; this uses in-lane unpacks and fixes the lane order afterwards.
+  static inline auto zip_bytes(u8x64 a, u8x64 b) -> u16x64 {
+    std::array<__m256i, 4> result;
+    for (usize i = 0; i < 2; i++) {
+      const __m256i lo = _mm256_unpacklo_epi8(a.raw[i].raw, b.raw[i].raw);
+      const __m256i hi = _mm256_unpackhi_epi8(a.raw[i].raw, b.raw[i].raw);
+      result[2 * i + 0] = _mm256_permute2x128_si256(lo, hi, 0x20);
+      result[2 * i + 1] = _mm256_permute2x128_si256(lo, hi, 0x31);
+    }
+    return std::bit_cast<u16x64>(result);
+  }
+#endif
+
   static inline auto expand_mask(m8x64 x) -> m16x64 {
 #if LPS_AVX512
     return x.convert<u16>();
+#elif LPS_AVX2
+    const u8x64 v = std::bit_cast<u8x64>(x.to_vector());
+    return std::bit_cast<m16x64>(zip_bytes(v, v));
 #else
     return concat<m16x64>(x.to_vector().zip_low(x.to_vector()), x.to_vector().zip_high(x.to_vector()));
 #endif
@@ -67,7 +85,11 @@ namespace rose {
     constexpr u8x16 hi_shift {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80}};
     const u8x64 bits_lo = ids.swizzle(lo_shift);
     const u8x64 bits_hi = ids.swizzle(hi_shift);
+#if LPS_AVX2
+    return zip_bytes(bits_lo, bits_hi);
+#else
     return concat<u16x64>(bits_lo.zip_low(bits_hi), bits_lo.zip_high(bits_hi));
+#endif
 #endif
   }
 
@@ -119,7 +141,7 @@ namespace rose {
     m_piece_list_ptype[color.to_index()][id] = ptype;
 
     u8x64 board = m_board.to_vector();
-    board = m8x64 {sq.to_bitboard().raw}.select(board, u8x64::splat(Place::make(color, ptype, id).raw));
+    board = geometry::bits_to_mask(sq.to_bitboard().raw).select(board, u8x64::splat(Place::make(color, ptype, id).raw));
     std::memcpy(m_board.mailbox.data(), &board, sizeof(board));
   }
 
@@ -133,7 +155,7 @@ namespace rose {
     m_piece_list_ptype[color.to_index()][id] = PieceType::none;
     if constexpr (update_sliders) {
       u8x64 board = m_board.to_vector();
-      board = m8x64 {~sq.to_bitboard().raw}.mask(board);
+      board = geometry::bits_to_mask(~sq.to_bitboard().raw).mask(board);
       std::memcpy(m_board.mailbox.data(), &board, sizeof(board));
     }
   }
@@ -145,9 +167,9 @@ namespace rose {
 
     u8x64 board = m_board.to_vector();
     const u8x64 src_ray_places = src_ray_coords.swizzle(board);
-    board = m8x64 {~src_sq.to_bitboard().raw}.mask(board);
+    board = geometry::bits_to_mask(~src_sq.to_bitboard().raw).mask(board);
     const u8x64 dst_ray_places = dst_ray_coords.swizzle(board);
-    board = m8x64 {dst_sq.to_bitboard().raw}.select(board, u8x64::splat(Place::make(color, dst_ptype, id).raw));
+    board = geometry::bits_to_mask(dst_sq.to_bitboard().raw).select(board, u8x64::splat(Place::make(color, dst_ptype, id).raw));
     std::memcpy(m_board.mailbox.data(), &board, sizeof(board));
 
     const u8x64 src_iperm = geometry::superpiece_inverse_rays_flipped(src_sq);
@@ -266,15 +288,15 @@ namespace rose {
     return Position::parse(black_rank + "/pppppppp/8/8/8/8/PPPPPPPP/" + white_rank + " w KQkq - 0 1").value();
   }
 
-  auto Position::is_castle_aside_legal() const -> bool {
-    return is_castle_legal(*this, m_rook_info.aside(m_stm), 3, 2);
+  auto Position::is_castle_aside_legal(const PinInfo& pin_info) const -> bool {
+    return is_castle_legal(*this, pin_info, m_rook_info.aside(m_stm), 3, 2);
   }
 
-  auto Position::is_castle_hside_legal() const -> bool {
-    return is_castle_legal(*this, m_rook_info.hside(m_stm), 5, 6);
+  auto Position::is_castle_hside_legal(const PinInfo& pin_info) const -> bool {
+    return is_castle_legal(*this, pin_info, m_rook_info.hside(m_stm), 5, 6);
   }
 
-  auto Position::is_legal(Move m) const -> bool {
+  auto Position::is_legal(Move m, const PinInfo& pin_info) const -> bool {
     if (m.is_none()) {
       return false;
     }
@@ -284,7 +306,7 @@ namespace rose {
     const Place src = m_board[m.from()];
     const Place dst = m_board[m.to()];
 
-    const auto [at, pinned] = pin_info();
+    const auto& [at, pinned] = pin_info;
 
     const bool valid_attack = at[m.to().to_index()].is_set(src.id());
 
@@ -292,9 +314,9 @@ namespace rose {
       return false;
 
     if (src.ptype() == PieceType::k) {
-      if (m.flags() == MoveFlags::castle_aside && m.to() == m_rook_info.aside(m_stm) && is_castle_aside_legal())
+      if (m.flags() == MoveFlags::castle_aside && m.to() == m_rook_info.aside(m_stm) && is_castle_aside_legal(pin_info))
         return true;
-      if (m.flags() == MoveFlags::castle_hside && m.to() == m_rook_info.hside(m_stm) && is_castle_hside_legal())
+      if (m.flags() == MoveFlags::castle_hside && m.to() == m_rook_info.hside(m_stm) && is_castle_hside_legal(pin_info))
         return true;
 
       const Bitboard danger = attack_table(!m_stm).bitboard_any();
@@ -370,16 +392,45 @@ namespace rose {
   }
 
   auto Position::has_no_legal_moves_slow() const -> bool {
-    const MoveList moves = generate_all_moves(*this);
-    return moves.size() == 0;
+    return count_legal_moves(*this) == 0;
   }
 
-  template<eval::concepts::Observer Observer>
-  auto Position::move(Move m, Observer observer) const -> Position {
+  auto Position::gives_check(Move m) const -> bool {
+    const Square from = m.from();
+    const Square to = m.to();
+    const Place src = m_board[from];
+
+    // Apply the move to a copy of the board. Piece ids do not matter here, only piece types and colors do.
+    u8x64 board = m_board.to_vector();
+    if (m.is_castle()) {
+      const Square king_dest {narrow_cast<u8>((from.raw & 0x38) | (m.flags() == MoveFlags::castle_aside ? 2 : 6))};
+      const Square rook_dest {narrow_cast<u8>((from.raw & 0x38) | (m.flags() == MoveFlags::castle_aside ? 3 : 5))};
+      board = geometry::bits_to_mask(~(from.to_bitboard() | to.to_bitboard()).raw).mask(board);
+      board = geometry::bits_to_mask(king_dest.to_bitboard().raw).select(board, u8x64::splat(src.raw));
+      board = geometry::bits_to_mask(rook_dest.to_bitboard().raw).select(board, u8x64::splat(m_board[to].raw));
+    } else {
+      Bitboard vacated = from.to_bitboard();
+      if (m.is_enpassant())
+        vacated |= Square::from_file_and_rank(to.file(), from.rank()).to_bitboard();
+      const Place dst = m.is_promo() ? Place::make(m_stm, m.ptype(), src.id()) : src;
+      board = geometry::bits_to_mask(~vacated.raw).mask(board);
+      board = geometry::bits_to_mask(to.to_bitboard().raw).select(board, u8x64::splat(dst.raw));
+    }
+
+    // Look outwards from the enemy king. The closest piece on each ray checks it if it is ours and moves along that ray.
+    // This covers direct checks by the moved piece and discovered checks through the vacated squares alike.
+    const auto [ray_coords, ray_valid] = geometry::superpiece_rays(king_sq(!m_stm));
+    const u8x64 ray_places = ray_coords.swizzle(board);
+
+    const m8x64 visible = geometry::superpiece_attacks(ray_places, ray_valid) & ray_places.nonzeros();
+    const m8x64 ours = ray_places.msb() ^ geometry::bits_to_mask((!m_stm).to_bitboard().raw);
+
+    return (visible & ours & geometry::attackers_from_rays(ray_places)).to_bits() != 0;
+  }
+
+  template<bool update_hashes, eval::concepts::Observer Observer>
+  auto Position::move_impl(Move m, Observer observer, Hashes* hashes) const -> Position {
     Position new_pos = *this;
-    new_pos.m_valid_pin_info = false;
-    new_pos.m_cached_pinned = {};
-    new_pos.m_cached_masked_attack_table = {};
 
     new_pos.m_enpassant = Square::invalid();
 
@@ -390,6 +441,15 @@ namespace rose {
     const PieceId src_id = src_place.id();
     const PieceId dest_id = dest_place.id();
 
+    Hashes new_hashes {};
+    if constexpr (update_hashes)
+      new_hashes = *hashes;
+
+    const auto toggle_piece = [&](Square sq, Color color, PieceType ptype) {
+      if constexpr (update_hashes)
+        new_hashes.toggle_piece(sq, color, ptype);
+    };
+
     if (src_place.ptype() == PieceType::k) {
       observer.on_king_move(new_pos, m_stm, from, to);
     }
@@ -408,6 +468,8 @@ namespace rose {
     const auto normal = [&] {
       new_pos.move_piece<false>(m_stm, from, to, src_id, src_place.ptype(), src_place.ptype());
       observer.on_move(*this, m_stm, src_place.ptype(), from, to);
+      toggle_piece(from, m_stm, src_place.ptype());
+      toggle_piece(to, m_stm, src_place.ptype());
       if (src_place.ptype() != PieceType::p) {
         new_pos.m_50mr++;
       } else {
@@ -421,6 +483,9 @@ namespace rose {
       observer.on_remove(*this, !m_stm, dest_place.ptype(), to);
       new_pos.move_piece<true>(m_stm, from, to, src_id, src_place.ptype(), src_place.ptype());
       observer.on_move(*this, m_stm, src_place.ptype(), from, to);
+      toggle_piece(to, !m_stm, dest_place.ptype());
+      toggle_piece(from, m_stm, src_place.ptype());
+      toggle_piece(to, m_stm, src_place.ptype());
       new_pos.m_50mr = 0;
       check_src_castling_rights();
       check_dest_castling_rights();
@@ -429,6 +494,8 @@ namespace rose {
     const auto promo = [&](auto ptype) {
       new_pos.move_piece<false>(m_stm, from, to, src_id, src_place.ptype(), decltype(ptype)::value);
       observer.on_promote(*this, m_stm, decltype(ptype)::value, from, to);
+      toggle_piece(from, m_stm, PieceType::p);
+      toggle_piece(to, m_stm, decltype(ptype)::value);
       new_pos.m_50mr = 0;
     };
 
@@ -437,6 +504,9 @@ namespace rose {
       observer.on_remove(*this, !m_stm, dest_place.ptype(), to);
       new_pos.move_piece<true>(m_stm, from, to, src_id, src_place.ptype(), decltype(ptype)::value);
       observer.on_promote(*this, m_stm, decltype(ptype)::value, from, to);
+      toggle_piece(to, !m_stm, dest_place.ptype());
+      toggle_piece(from, m_stm, PieceType::p);
+      toggle_piece(to, m_stm, decltype(ptype)::value);
       new_pos.m_50mr = 0;
       check_dest_castling_rights();
     };
@@ -444,6 +514,8 @@ namespace rose {
     const auto double_push = [&] {
       new_pos.move_piece<false>(m_stm, from, to, src_id, src_place.ptype(), src_place.ptype());
       observer.on_move(*this, m_stm, src_place.ptype(), from, to);
+      toggle_piece(from, m_stm, PieceType::p);
+      toggle_piece(to, m_stm, PieceType::p);
       new_pos.m_50mr = 0;
       new_pos.m_enpassant = Square {narrow_cast<u8>((from.raw + to.raw) >> 1)};
     };
@@ -456,6 +528,9 @@ namespace rose {
       observer.on_remove(*this, !m_stm, PieceType::p, victim);
       new_pos.move_piece<false>(m_stm, from, to, src_id, src_place.ptype(), src_place.ptype());
       observer.on_move(*this, m_stm, src_place.ptype(), from, to);
+      toggle_piece(victim, !m_stm, PieceType::p);
+      toggle_piece(from, m_stm, PieceType::p);
+      toggle_piece(to, m_stm, PieceType::p);
 
       new_pos.m_50mr = 0;
     };
@@ -476,6 +551,10 @@ namespace rose {
       observer.on_add(*this, m_stm, PieceType::k, king_dest);
       new_pos.add_piece<true>(m_stm, rook_dest, rook_id, PieceType::r);
       observer.on_add(*this, m_stm, PieceType::r, rook_dest);
+      toggle_piece(king_src, m_stm, PieceType::k);
+      toggle_piece(king_dest, m_stm, PieceType::k);
+      toggle_piece(rook_src, m_stm, PieceType::r);
+      toggle_piece(rook_dest, m_stm, PieceType::r);
 
       new_pos.m_50mr++;
       new_pos.m_rook_info.clear(m_stm);
@@ -532,21 +611,51 @@ namespace rose {
     new_pos.m_since_null++;
     new_pos.m_stm = !m_stm;
 
+#if ROSE_INCREMENTAL_PINS
+    // Pins against a king can only change if a square on one of its lines changed, which includes the king moving.
+    const Bitboard changed {~m_board.to_vector().eq(new_pos.m_board.to_vector()).to_bits()};
+    for (const Color color : {Color::white, Color::black}) {
+      if (!(changed & rays::lines_through(new_pos.king_sq(color))).is_empty())
+        new_pos.m_pinned[color.to_index()] = new_pos.calc_pinned(color);
+    }
+#endif
+
     observer.on_finalize(new_pos);
 
+    // En passant, castling rights and side to move are taken from the final state rather than from the move kind.
+    if constexpr (update_hashes) {
+      if (m_enpassant.is_valid())
+        new_hashes.toggle_enpassant(m_enpassant);
+      if (new_pos.m_enpassant.is_valid())
+        new_hashes.toggle_enpassant(new_pos.m_enpassant);
+      new_hashes.toggle_castle(m_rook_info.to_index());
+      new_hashes.toggle_castle(new_pos.m_rook_info.to_index());
+      new_hashes.toggle_stm();
+      *hashes = new_hashes;
+    }
+
     return new_pos;
   }
 
+  template<eval::concepts::Observer Observer>
+  auto Position::move(Move m, Observer observer) const -> Position {
+    return move_impl<false>(m, observer, nullptr);
+  }
+
+  template<eval::concepts::Observer Observer>
+  auto Position::move(Move m, Hashes& hashes, Observer observer) const -> Position {
+    return move_impl<true>(m, observer, &hashes);
+  }
+
   template auto Position::move<eval::NullObserver>(Move m, eval::NullObserver observer) const -> Position;
+  template auto Position::move<eval::NullObserver>(Move m, Hashes& hashes, eval::NullObserver observer) const -> Position;
 #define rose_position_move_template(e, T)                                                                                                            \
-  template auto Position::move<eval::nnue::T::Observer>(Move m, eval::nnue::T::Observer observer) const -> Position;
+  template auto Position::move<eval::nnue::T::Observer>(Move m, eval::nnue::T::Observer observer) const -> Position;                                 \
+  template auto Position::move<eval::nnue::T::Observer>(Move m, Hashes& hashes, eval::nnue::T::Observer observer) const -> Position;
   rose_for_each_arch(rose_position_move_template);
 
   auto Position::null_move() const -> Position {
     Position new_pos = *this;
-    new_pos.m_valid_pin_info = false;
-    new_pos.m_cached_pinned = {};
-    new_pos.m_cached_masked_attack_table = {};
 
     if (new_pos.m_enpassant.is_valid()) {
       new_pos.m_enpassant = Square::invalid();
@@ -723,25 +832,24 @@ namespace rose {
     return result;
   }
 
-  auto Position::pin_info() const -> std::tuple<const std::array<PieceMask, 64>&, Bitboard> {
-    if (!m_valid_pin_info) {
-      m_valid_pin_info = true;
-      std::tie(m_cached_masked_attack_table, m_cached_pinned) = calc_pin_info_slow();
-    }
-    return std::tie(m_cached_masked_attack_table, m_cached_pinned);
-  }
-
-  auto Position::calc_pin_info_slow() const -> std::tuple<std::array<PieceMask, 64>, Bitboard> {
-    const Square sq = king_sq(m_stm);
+  struct PinRays {
+    u8x64 ray_coords;
+    u8x64 ray_places;
+    u8x64 iperm;
+    m8x64 pinned;
+    m8x64 pin_raymasks;
+  };
 
+  // Finds the pieces of color that are pinned to their king at sq, as lanes of the superpiece rays around sq.
+  static inline auto find_pins(const Byteboard& board, Color color, Square sq) -> PinRays {
     const auto [ray_coords, ray_valid_premask] = geometry::superpiece_rays(sq);
     const m8x64 ray_valid = ray_valid_premask & m8x64 {0xFEFEFEFEFEFEFEFE};
-    const u8x64 ray_places = ray_coords.swizzle(m_board.to_vector());
+    const u8x64 ray_places = ray_coords.swizzle(board.to_vector());
     const u8x64 iperm = geometry::superpiece_inverse_rays(sq);
 
     const m8x64 blockers = ray_places.nonzeros();
-    const m8x64 color = ray_places.msb();
-    const m8x64 enemy = (color ^ m8x64 {m_stm.to_bitboard().raw}) & blockers;
+    const m8x64 piece_color = ray_places.msb();
+    const m8x64 enemy = (piece_color ^ geometry::bits_to_mask(color.to_bitboard().raw)) & blockers;
 
     // Closest blockers
     const m8x64 potentially_pinned = blockers & geometry::superpiece_attacks(ray_places, ray_valid);
@@ -759,6 +867,17 @@ namespace rose {
     const m8x64 has_attacker = geometry::ray_fill(attackers);
     const m8x64 pinned = potentially_pinned.andnot(enemy) & has_attacker;
 
+    return {ray_coords, ray_places, iperm, pinned, pin_raymasks};
+  }
+
+  auto Position::calc_pin_info() const -> PinInfo {
+#if ROSE_INCREMENTAL_PINS
+    if (m_pinned[m_stm.to_index()].is_empty())
+      return {m_attack_table[m_stm.to_index()].to_mailbox(), Bitboard {}};
+#endif
+
+    const auto [ray_coords, ray_places, iperm, pinned, pin_raymasks] = find_pins(m_board, m_stm, king_sq(m_stm));
+
     // Translate to valid move rays
     const u8x64 nonmasked_pinned_ids = geometry::lane_broadcast(pinned.mask(ray_places));
     const u8x64 pinned_ids = pin_raymasks.mask(nonmasked_pinned_ids);
@@ -783,6 +902,13 @@ namespace rose {
     return {Wordboard {m_attack_table[m_stm.to_index()].raw & at_mask}.to_mailbox(), pinned_bb};
   }
 
+#if ROSE_INCREMENTAL_PINS
+  auto Position::calc_pinned(Color color) const -> Bitboard {
+    const auto [ray_coords, ray_places, iperm, pinned, pin_raymasks] = find_pins(m_board, color, king_sq(color));
+    return Bitboard {iperm.swizzle(pinned).andnot(iperm.msb()).to_bits()};
+  }
+#endif
+
   auto Position::calc_attacks_slow() const -> std::array<Wordboard, 2> {
     std::array<std::array<PieceMask, 64>, 2> result {};
     for (int i = 0; i < 64; i++) {
@@ -962,6 +1088,9 @@ namespace rose {
 
     result.m_since_null = 0;
     result.m_attack_table = result.calc_attacks_slow();
+#if ROSE_INCREMENTAL_PINS
+    result.m_pinned = {result.calc_pinned(Color::white), result.calc_pinned(Color::black)};
+#endif
 
     return result;
   }
@@ -1005,7 +1134,7 @@ namespace rose {
     fmt::print("m_stm: {}\n", m_stm);
     // calc_pin_info:
     {
-      const auto [at, pinned] = calc_pin_info_slow();
+      const auto [at, pinned] = calc_pin_info();
       fmt::print("pinned-masked m_attack_table:\n");
       for (int r = 7; r >= 0; r--) {
         for (int f = 0; f < 8; f++) {
@@ -14,6 +14,12 @@
 #include <tuple>
 #include <type_traits>
 
+// When enabled, Position::move keeps track of the pinned pieces of both sides, recomputing them only when a move touches
+// a line through a king. calc_pin_info can then skip the pin search for the common case of no pins.
+#ifndef ROSE_INCREMENTAL_PINS
+#define ROSE_INCREMENTAL_PINS 0
+#endif
+
 namespace rose {
 
   template<typename T>
@@ -122,6 +128,13 @@ namespace rose {
     constexpr auto operator==(const RookInfo&) const -> bool = default;
   };
 
+  // The side to move's attack table with pinned pieces restricted to their pin rays, and the pinned pieces themselves.
+  // It is derived from a Position on demand and kept outside of it, so that it is not copied on every move.
+  struct PinInfo {
+    std::array<PieceMask, 64> masked_attack_table;
+    Bitboard pinned;
+  };
+
   struct Position {
   private:
     std::array<Wordboard, 2> m_attack_table {};
@@ -134,10 +147,9 @@ namespace rose {
     u16 m_ply {};
     Square m_enpassant = Square::invalid();
     Color m_stm {};
-
-    mutable std::array<PieceMask, 64> m_cached_masked_attack_table {};
-    mutable Bitboard m_cached_pinned {};
-    mutable bool m_valid_pin_info = false;
+#if ROSE_INCREMENTAL_PINS
+    std::array<Bitboard, 2> m_pinned {};
+#endif
 
     auto add_attacks(Color color, Square sq, PieceId id, PieceType ptype) -> void;
     auto remove_attacks(Color color, PieceId id) -> void;
@@ -150,6 +162,13 @@ namespace rose {
     template<bool is_capture>
     auto move_piece(Color color, Square src, Square dst, PieceId id, PieceType src_ptype, PieceType dst_ptype) -> void;
 
+    template<bool update_hashes, eval::concepts::Observer Observer>
+    auto move_impl(Move m, Observer observer, Hashes* hashes) const -> Position;
+
+#if ROSE_INCREMENTAL_PINS
+    auto calc_pinned(Color color) const -> Bitboard;
+#endif
+
   public:
     static auto startpos() -> Position;
     static auto frcstartpos(usize index) -> Position;
@@ -240,26 +259,39 @@ namespace rose {
       return !checkers().is_empty();
     }
 
-    auto is_castle_aside_legal() const -> bool;
-    auto is_castle_hside_legal() const -> bool;
-    auto is_legal(Move m) const -> bool;
+    auto is_castle_aside_legal(const PinInfo& pin_info) const -> bool;
+    auto is_castle_hside_legal(const PinInfo& pin_info) const -> bool;
+    auto is_legal(Move m, const PinInfo& pin_info) const -> bool;
+
+    auto is_legal(Move m) const -> bool {
+      return m.is_some() && is_legal(m, calc_pin_info());
+    }
 
     auto has_no_legal_moves_slow() const -> bool;
 
+    // Whether the pseudo-legal move m leaves the opponent in check, without making it.
+    auto gives_check(Move m) const -> bool;
+
     template<eval::concepts::Observer Observer>
     auto move(Move m, Observer observer) const -> Position;
+    // Also advances hashes from this position's hashes to those of the new position, equivalent to hashes_after.
+    template<eval::concepts::Observer Observer>
+    auto move(Move m, Hashes& hashes, Observer observer) const -> Position;
     auto null_move() const -> Position;
 
     auto move(Move m) const -> Position {
       return move(m, eval::NullObserver {});
     }
 
+    auto move(Move m, Hashes& hashes) const -> Position {
+      return move(m, hashes, eval::NullObserver {});
+    }
+
     auto hashes_after(Hashes prev, Move m) const -> Hashes;
     auto hashes_after_null_move(Hashes prev) const -> Hashes;
     auto calc_hashes_slow() const -> Hashes;
 
-    auto pin_info() const -> std::tuple<const std::array<PieceMask, 64>&, Bitboard>;
-    auto calc_pin_info_slow() const -> std::tuple<std::array<PieceMask, 64>, Bitboard>;
+    auto calc_pin_info() const -> PinInfo;
 
     auto calc_attacks_slow() const -> std::array<Wordboard, 2>;
     auto calc_attacks_slow(Square sq) const -> std::array<PieceMask, 2>;
@@ -78,4 +78,22 @@ namespace rose::rays {
     return Bitboard {std::rotl(base[direction], k.raw)};
   }
 
+  // All squares that share a rank, file or diagonal with sq, including sq itself.
+  inline constexpr auto lines_through(Square sq) -> Bitboard {
+    constexpr std::array<u64, 64> table = [] consteval {
+      std::array<u64, 64> result {};
+      for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+          const int file = (b & 7) - (a & 7);
+          const int rank = (b >> 3) - (a >> 3);
+          if (file == 0 || rank == 0 || file == rank || file == -rank)
+            result[a] |= u64 {1} << b;
+        }
+      }
+      return result;
+    }();
+
+    return Bitboard {table[sq.raw]};
+  }
+
 }  // namespace rose::rays
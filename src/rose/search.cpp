@@ -185,7 +185,8 @@ namespace rose {
     }
 
     // Otherwise, rely on our move ordering to pick a move.
-    MovePicker moves {m_sd, m_root, &m_search_stack[search_stack_offset], Move::none()};
+    const PinInfo pin_info = m_root.calc_pin_info();
+    MovePicker moves {m_sd, m_root, pin_info, &m_search_stack[search_stack_offset], Move::none()};
     pv.write(moves.next());
     return 0;
   }
@@ -445,8 +446,10 @@ namespace rose {
         return iid_tte.score;
     }
 
+    const PinInfo pin_info = position.calc_pin_info();
+
     // Hint move legality check
-    if (!position.is_legal(hint_move)) {
+    if (!position.is_legal(hint_move, pin_info)) {
       hint_move = Move::none();
     }
 
@@ -481,7 +484,7 @@ namespace rose {
       }
     }
 
-    MovePicker moves {m_sd, position, ss, hint_move};
+    MovePicker moves {m_sd, position, pin_info, ss, hint_move};
 
     MoveList fail_low_quiets;
     MoveList fail_low_noisies;
@@ -528,12 +531,12 @@ namespace rose {
         }
 
         // Quiet SEE Pruning
-        if (!mv.is_noisy() && depth <= 11 && !see::see(position, mv, 32_z - 49_z * depth - 34_z * history / 1024)) {
+        if (!mv.is_noisy() && depth <= 11 && !moves.see(mv, 32_z - 49_z * depth - 34_z * history / 1024)) {
           continue;
         }
 
         // Noisy SEE Pruning
-        if (mv.is_noisy() && depth <= 11 && !see::see(position, mv, -73_z * depth)) {
+        if (mv.is_noisy() && depth <= 11 && !moves.see(mv, -73_z * depth)) {
           continue;
         }
       }
@@ -785,7 +788,8 @@ namespace rose {
     }
     alpha = std::max(alpha, best_score);
 
-    MovePicker moves {m_sd, position, ss, Move::none()};
+    const PinInfo pin_info = position.calc_pin_info();
+    MovePicker moves {m_sd, position, pin_info, ss, Move::none()};
     if (!is_in_check)
       moves.skip_quiet();
 
@@ -795,12 +799,12 @@ namespace rose {
     for (Move mv = moves.next(); mv.is_some(); mv = moves.next()) {
       if (!score::is_loss(best_score) && !is_in_check) {
         // QS SEE Pruning
-        if (!see::see(position, mv, 0))
+        if (!moves.see(mv, 0))
           continue;
 
         // QS Futility Pruning
         const Score futility = static_eval + 167_z;
-        if (futility <= alpha && !see::see(position, mv, 1)) {
+        if (futility <= alpha && !moves.see(mv, 1)) {
           best_score = std::max(best_score, futility);
           continue;
         }
@@ -852,7 +856,17 @@ namespace rose {
 
   template<eval::concepts::State Evaluation>
   auto Search<Evaluation>::eval(const Position& position) -> Score {
-    return m_evaluation.evaluate(position);
+    const Hash hash = m_hash_stack.back().full();
+
+    stats().eval_cache_probes.fetch_add(1, std::memory_order_relaxed);
+    if (const auto cached = m_eval_cache.load(hash)) {
+      stats().eval_cache_hits.fetch_add(1, std::memory_order_relaxed);
+      return *cached;
+    }
+
+    const Score raw_eval = m_evaluation.evaluate(position);
+    m_eval_cache.store(hash, raw_eval);
+    return raw_eval;
   }
 
   template<eval::concepts::State Evaluation>
@@ -884,8 +898,9 @@ namespace rose {
   template<eval::concepts::State Evaluation>
   auto Search<Evaluation>::make_move(SearchStack* ss, const Position& position, Move mv) -> Position {
     m_evaluation.push();
-    m_hash_stack.push_back(position.hashes_after(m_hash_stack.back(), mv));
-    const Position child_position = position.move(mv, m_evaluation.observer());
+    Hashes child_hashes = m_hash_stack.back();
+    const Position child_position = position.move(mv, child_hashes, m_evaluation.observer());
+    m_hash_stack.push_back(child_hashes);
     ss->move = mv;
     ss->conthist = m_sd.continuation_history.get_subtable(!child_position.stm(), child_position.ptype_at(mv.to()), mv);
     ss[1].raw_static_eval = score::none;
@@ -2,6 +2,7 @@
 
 #include "rose/engine.hpp"
 #include "rose/engine_output.hpp"
+#include "rose/eval_cache.hpp"
 #include "rose/game.hpp"
 #include "rose/hash.hpp"
 #include "rose/history.hpp"
@@ -88,6 +89,20 @@ namespace rose {
         total += s.nodes.load(std::memory_order_relaxed);
       return total;
     }
+
+    auto total_eval_cache_probes() -> u64 {
+      u64 total = 0;
+      for (const SearchStats& s : stats)
+        total += s.eval_cache_probes.load(std::memory_order_relaxed);
+      return total;
+    }
+
+    auto total_eval_cache_hits() -> u64 {
+      u64 total = 0;
+      for (const SearchStats& s : stats)
+        total += s.eval_cache_hits.load(std::memory_order_relaxed);
+      return total;
+    }
   };
 
   struct SearchStack {
@@ -147,6 +162,7 @@ namespace rose {
     std::array<SearchStack, max_depth + search_stack_offset + search_stack_safety> m_search_stack;
 
     Evaluation m_evaluation;
+    EvalCache m_eval_cache;
 
     SearchData m_sd;
     std::optional<i32> m_nmr_ply;
@@ -7,9 +7,13 @@
 namespace rose {
   struct alignas(64) SearchStats {
     std::atomic<u64> nodes {0};
+    std::atomic<u64> eval_cache_probes {0};
+    std::atomic<u64> eval_cache_hits {0};
 
     void reset() {
       nodes.store(0);
+      eval_cache_probes.store(0);
+      eval_cache_hits.store(0);
     }
   };
 }  // namespace rose
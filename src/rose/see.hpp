@@ -6,6 +6,7 @@
 #include "rose/position.hpp"
 #include "rose/score.hpp"
 #include "rose/square.hpp"
+#include "rose/util/assert.hpp"
 
 #include <array>
 #include <bit>
@@ -33,9 +34,44 @@ namespace rose::see {
     return score;
   }
 
-  inline bool see(const Position& pos, Move mv, Score threshold) {
-    const Square sq = mv.to();
+  // The pieces around a square, as bitrays over its superpiece rays. This is independent of the move that starts an
+  // exchange on the square, so it can be shared between all captures of the same piece.
+  struct Exchange {
+    std::array<u64, 8> ptype_bits;
+    u64 color;
+    u64 attackers;
+    u64 occupied;
+  };
+
+  inline Exchange exchange(const Position& pos, Square sq) {
+    const auto [ray_coords, ray_valid] = geometry::superpiece_rays(sq);
+    const u8x64 ray_places = ray_coords.swizzle(pos.board().to_vector());
+    const u8x64 ray_attackers = geometry::attackers_from_rays(ray_places).mask(ray_places);
+    const u8x64 ptypes = ray_valid.mask(ray_attackers & u8x64::splat(Place::ptype_mask));
+
+    // Extract bitrays for each piece type
+    // Note: Due to Rose's unique ptype ordering, we need to offset the ptype values by 2, so king comes last.
+    return {
+      .ptype_bits {
+        ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::p) << Place::ptype_shift)).to_bits(),
+        0x0101010101010101,  // Knight
+        0,                   // Invalid
+        ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::b) << Place::ptype_shift)).to_bits(),
+        ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::r) << Place::ptype_shift)).to_bits(),
+        ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::q) << Place::ptype_shift)).to_bits(),
+        0,  // None
+        ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::k) << Place::ptype_shift)).to_bits(),
+      },
+      .color = ray_places.test(u8x64::splat(Place::color_mask)).to_bits(),
+      .attackers = (ray_attackers.nonzeros() & ray_valid).to_bits(),
+      .occupied = (ray_places.nonzeros() & ray_valid).to_bits(),
+    };
+  }
 
+  // get_exchange is only called for moves that the material balance alone cannot decide, and must return the Exchange
+  // for mv.to().
+  template<typename F>
+  inline bool see(const Position& pos, Move mv, Score threshold, F get_exchange) {
     Color stm = pos.stm();
     Score score = gain(pos, mv) - threshold;
     if (score < 0) {
@@ -49,33 +85,20 @@ namespace rose::see {
       return true;
     }
 
-    const auto [ray_coords, ray_valid] = geometry::superpiece_rays(sq);
-    const u8x64 ray_places = ray_coords.swizzle(pos.board().to_vector());
-    const u8x64 ray_attackers = geometry::attackers_from_rays(ray_places).mask(ray_places);
-    const u8x64 ptypes = ray_valid.mask(ray_attackers & u8x64::splat(Place::ptype_mask));
-
-    const u64 color = ray_places.test(u8x64::splat(Place::color_mask)).to_bits();
-    const u64 attackers = (ray_attackers.nonzeros() & ray_valid).to_bits();
-    u64 occupied = (ray_places.nonzeros() & ray_valid).to_bits();
+    const Exchange& ex = get_exchange();
+    const std::array<u64, 8>& ptype_bits = ex.ptype_bits;
+    const u64 color = ex.color;
+    const u64 attackers = ex.attackers;
+    u64 occupied = ex.occupied;
 
     // Remove already moved piece and enpassant victim
-    occupied ^= ray_coords.eq(u8x64::splat(mv.from().raw)).to_bits();
+    const u8 from_lane = geometry::superpiece_inverse_rays(mv.to()).read(mv.from().raw);
+    rose_assert(from_lane < 64);
+    occupied &= ~(u64 {1} << from_lane);
     if (mv.is_enpassant()) {
       occupied &= pos.stm() == Color::black ? 0xFFFFFFFFFFFFFFFD : 0xFFFFFFFDFFFFFFFF;
     }
 
-    // Extract bitrays for each piece type
-    // Note: Due to Rose's unique ptype ordering, we need to offset the ptype values by 2, so king comes last.
-    std::array<u64, 8> ptype_bits {
-      ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::p) << Place::ptype_shift)).to_bits(),
-      0x0101010101010101,  // Knight
-      0,                   // Invalid
-      ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::b) << Place::ptype_shift)).to_bits(),
-      ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::r) << Place::ptype_shift)).to_bits(),
-      ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::q) << Place::ptype_shift)).to_bits(),
-      0,  // None
-      ptypes.eq(u8x64::splat(static_cast<u8>(PieceType::k) << Place::ptype_shift)).to_bits(),
-    };
     u64x8 ptype_vec {ptype_bits};
 
     auto current_attackers = [&]() {
@@ -104,4 +127,95 @@ namespace rose::see {
     return stm != pos.stm();
   }
 
+  inline bool see(const Position& pos, Move mv, Score threshold) {
+    return see(pos, mv, threshold, [&] { return exchange(pos, mv.to()); });
+  }
+
+  // Remembers the exchanges on the squares seen at one node, so that several captures of the same piece (for example,
+  // capture-promotions to each piece type) only extract the rays around the square once.
+  struct ExchangeCache {
+  private:
+    // Captures at a node rarely target more than a handful of distinct squares, and the cache lives in every MovePicker
+    // on the search stack.
+    static constexpr usize capacity = 8;
+
+    usize m_size = 0;
+    std::array<Square, capacity> m_squares;
+    std::array<Exchange, capacity> m_exchanges;
+
+  public:
+    bool see(const Position& pos, Move mv, Score threshold) {
+      return see::see(pos, mv, threshold, [&]() -> Exchange {
+        const Square sq = mv.to();
+        for (usize i = 0; i < m_size; i++) {
+          if (m_squares[i] == sq)
+            return m_exchanges[i];
+        }
+
+        const Exchange ex = exchange(pos, sq);
+        if (m_size < capacity) {
+          m_squares[m_size] = sq;
+          m_exchanges[m_size] = ex;
+          m_size++;
+        }
+        return ex;
+      });
+    }
+  };
+
+  // The least valuable enemy attacker of every square, and the squares attacked by enemy sliders, taken from the attack
+  // tables. It is built on first use at a node and decides quiet moves without looking at the rays around their
+  // destination whenever the first recapture settles the exchange.
+  struct SafetyMap {
+  private:
+    bool m_built = false;
+    u16x64 m_least_attacker;
+    Bitboard m_slider_attacked;
+
+    auto build(const Position& pos) -> void {
+      const Color them = !pos.stm();
+      const u16x64 at = pos.attack_table(them).raw;
+
+      const auto attacked_by = [&](PieceMask pm) {
+        return at.test(u16x64::splat(pm.raw));
+      };
+
+      u16x64 least = u16x64::splat(0);
+      least = attacked_by(pos.piece_mask_for<PieceType::k>(them)).select(least, u16x64::splat(value(PieceType::k)));
+      least = attacked_by(pos.piece_mask_for<PieceType::q>(them)).select(least, u16x64::splat(value(PieceType::q)));
+      least = attacked_by(pos.piece_mask_for<PieceType::r>(them)).select(least, u16x64::splat(value(PieceType::r)));
+      least = attacked_by(pos.piece_mask_for<PieceType::n, PieceType::b>(them)).select(least, u16x64::splat(value(PieceType::n)));
+      least = attacked_by(pos.piece_mask_for<PieceType::p>(them)).select(least, u16x64::splat(value(PieceType::p)));
+
+      m_least_attacker = least;
+      m_slider_attacked = Bitboard {attacked_by(pos.piece_mask_for<PieceType::b, PieceType::r, PieceType::q>(them)).to_bits()};
+      m_built = true;
+    }
+
+  public:
+    // Equivalent to see::see for quiet moves.
+    bool see(const Position& pos, Move mv, Score threshold) {
+      if (mv.is_promo() || mv.is_castle())
+        return see::see(pos, mv, threshold);
+
+      if (!m_built)
+        build(pos);
+
+      // An enemy slider behind the moved piece would join the exchange once the piece has left.
+      if (m_slider_attacked.read(mv.from()))
+        return see::see(pos, mv, threshold);
+
+      const Score moved = value(pos.ptype_at(mv.from()));
+      const Score least = m_least_attacker.read(mv.to().raw);
+
+      if (least == 0 || threshold + moved <= 0)
+        return threshold <= 0;
+      // The first recapture already takes the balance below the threshold, whatever we recapture with.
+      if (least != value(PieceType::k) && threshold + moved - 1 - least >= 0)
+        return false;
+
+      return see::see(pos, mv, threshold);
+    }
+  };
+
 }  // namespace rose::see
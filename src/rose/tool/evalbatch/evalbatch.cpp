@@ -0,0 +1,113 @@
+#include "rose/tool/evalbatch/evalbatch.hpp"
+
+#include "rose/common.hpp"
+#include "rose/eval/nnue/batch.hpp"
+#include "rose/eval/nnue/network.hpp"
+#include "rose/position.hpp"
+#include "rose/score.hpp"
+#include "rose/util/defer.hpp"
+#include "rose/util/string.hpp"
+#include "rose/util/time.hpp"
+#include "rose/util/tokenizer.hpp"
+
+#include <cstdio>
+#include <expected>
+#include <fmt/format.h>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rose::tool::evalbatch {
+
+  using namespace eval::nnue;
+
+  // Number of positions read and evaluated at a time, to bound memory use on large inputs.
+  inline constexpr usize chunk_size = 1 << 16;
+
+  static auto parse_line(std::string_view line) -> std::expected<Position, ParseError> {
+    Tokenizer it {line};
+    const std::string_view board = it.next();
+    const std::string_view color = it.next();
+    const std::string_view castling = it.next();
+    const std::string_view enpassant = it.next();
+
+    // EPD has no move counters; whatever follows the first four fields is either the FEN counters or EPD opcodes.
+    std::string_view clock_50mr = it.next();
+    std::string_view ply = it.next();
+    if (!parse_u16(clock_50mr) || !parse_u16(ply)) {
+      clock_50mr = "0";
+      ply = "1";
+    }
+
+    return Position::parse(board, color, castling, enpassant, clock_50mr, ply);
+  }
+
+  auto run(const std::string& network_path, const std::string& input_path, const std::string& output_path, usize thread_count) -> bool {
+    const std::expected<LoadedNetwork, NetworkError> network =
+      network_path == "<embedded>" ? LoadedNetwork::embedded() : LoadedNetwork::load(network_path);
+    if (!network) {
+      fmt::print("Could not load {}: {}\n", network_path, network.error());
+      return false;
+    }
+
+    std::ifstream input {input_path};
+    if (!input) {
+      fmt::print("Could not read {}\n", input_path);
+      return false;
+    }
+
+    FILE* output = std::fopen(output_path.c_str(), "wb");
+    if (!output) {
+      fmt::print("Could not write {}\n", output_path);
+      return false;
+    }
+    rose_defer {
+      std::fclose(output);
+    };
+
+    fmt::print("Evaluating {} with {} network on {} threads\n", input_path, network->arch(), thread_count);
+
+    const time::TimePoint start_time = time::Clock::now();
+
+    std::vector<Position> positions;
+    std::vector<Score> scores;
+    positions.reserve(chunk_size);
+
+    usize line_number = 0;
+    u64 total = 0;
+
+    const auto flush = [&] {
+      scores.resize(positions.size());
+      evaluate_batch(*network, positions, scores, thread_count);
+      for (const Score score : scores)
+        fmt::print(output, "{}\n", score);
+      total += positions.size();
+      positions.clear();
+    };
+
+    std::string line;
+    while (std::getline(input, line)) {
+      line_number++;
+
+      const auto pos = parse_line(line);
+      if (!pos) {
+        fmt::print("{}:{}: invalid position ({}): {}\n", input_path, line_number, pos.error(), line);
+        return false;
+      }
+
+      positions.push_back(*pos);
+      if (positions.size() == chunk_size)
+        flush();
+    }
+    flush();
+
+    const time::Duration elapsed = time::Clock::now() - start_time;
+    fmt::print("Evaluated {} positions in {:.2f}s ({} positions/s)\n",
+               total,
+               time::cast<time::FloatSeconds>(elapsed).count(),
+               time::nps<u64>(total, elapsed));
+    return true;
+  }
+
+}  // namespace rose::tool::evalbatch
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "rose/common.hpp"
+
+#include <string>
+
+namespace rose::tool::evalbatch {
+
+  // Reads one FEN or EPD per line from input_path and writes the raw static evaluation of each position, one per line and
+  // in the same order, to output_path. EPD lines without move counters default to "0 1"; trailing EPD opcodes are ignored.
+  // Pass "<embedded>" as network_path to use the built-in network.
+  auto run(const std::string& network_path, const std::string& input_path, const std::string& output_path, usize thread_count) -> bool;
+
+}  // namespace rose::tool::evalbatch
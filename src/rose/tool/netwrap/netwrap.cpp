@@ -0,0 +1,101 @@
+#include "rose/tool/netwrap/netwrap.hpp"
+
+#include "rose/common.hpp"
+#include "rose/eval/nnue/arch.hpp"
+#include "rose/eval/nnue/container.hpp"
+
+#include <cstddef>
+#include <fmt/format.h>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rose::tool::netwrap {
+
+  using namespace eval::nnue;
+
+  static auto read_file(const std::string& path) -> std::optional<std::vector<std::byte>> {
+    std::ifstream file {path, std::ios::binary};
+    if (!file)
+      return std::nullopt;
+    const std::vector<char> chars {std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> {}};
+    const auto bytes = std::as_bytes(std::span {chars});
+    return std::vector<std::byte> {bytes.begin(), bytes.end()};
+  }
+
+  static auto write_file(const std::string& path, std::span<const std::byte> header, std::span<const std::byte> payload) -> bool {
+    std::ofstream file {path, std::ios::binary};
+    file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    return static_cast<bool>(file);
+  }
+
+  static auto infer_arch(usize size) -> std::optional<ArchId> {
+    std::optional<ArchId> found;
+    bool ambiguous = false;
+#define rose_match_size(name, T)                                                                                                                     \
+  if (container::payload_size_matches<T>(size)) {                                                                                                    \
+    ambiguous |= found.has_value();                                                                                                                  \
+    found = ArchId::name;                                                                                                                            \
+  }
+    rose_for_each_arch(rose_match_size)
+#undef rose_match_size
+    return ambiguous ? std::nullopt : found;
+  }
+
+  auto run(std::string_view arch_str, const std::string& input_path, const std::string& output_path) -> bool {
+    const std::optional<ArchId> requested_arch = arch_str == "auto" ? std::nullopt : parse_arch_name(arch_str);
+    if (arch_str != "auto" && !requested_arch) {
+      fmt::print("Unknown architecture `{}`\n", arch_str);
+      return false;
+    }
+
+    const auto input = read_file(input_path);
+    if (!input) {
+      fmt::print("Could not read {}\n", input_path);
+      return false;
+    }
+
+    if (const auto parsed = container::parse(*input)) {
+      const auto [arch, payload] = *parsed;
+      if (requested_arch && *requested_arch != arch) {
+        fmt::print("{} is already a {} container, but {} was requested\n", input_path, arch, *requested_arch);
+        return false;
+      }
+      fmt::print("{} is already a valid {} container\n", input_path, arch);
+      return write_file(output_path, std::span {*input}.first(sizeof(container::Header)), payload);
+    } else if (parsed.error() != NetworkError::bad_magic && parsed.error() != NetworkError::too_small) {
+      fmt::print("{} is a corrupt container: {}\n", input_path, parsed.error());
+      return false;
+    }
+
+    const std::optional<ArchId> arch = requested_arch ? requested_arch : infer_arch(input->size());
+    if (!arch) {
+      fmt::print("Could not infer the architecture of {} from its size ({} bytes); please specify it\n", input_path, input->size());
+      return false;
+    }
+
+    const std::optional<container::Header> header = visit_arch(*arch, [&]<typename Arch>() -> std::optional<container::Header> {
+      if (!container::payload_size_matches<Arch>(input->size()))
+        return std::nullopt;
+      return container::make_header<Arch>(*input);
+    });
+    if (!header) {
+      fmt::print("Size of {} ({} bytes) does not match architecture {}\n", input_path, input->size(), *arch);
+      return false;
+    }
+
+    if (!write_file(output_path, std::as_bytes(std::span {&*header, 1}), *input)) {
+      fmt::print("Could not write {}\n", output_path);
+      return false;
+    }
+
+    fmt::print("Wrapped {} as {} (hash {:016x})\n", input_path, *arch, header->content_hash);
+    return true;
+  }
+
+}  // namespace rose::tool::netwrap
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "rose/common.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace rose::tool::netwrap {
+
+  // Wraps a raw network in a .rosenet container. Pass "auto" as arch to infer the architecture from the file size.
+  // Inputs that are already valid containers are copied through unchanged.
+  auto run(std::string_view arch, const std::string& input_path, const std::string& output_path) -> bool;
+
+}  // namespace rose::tool::netwrap
@@ -0,0 +1,86 @@
+#include "rose/util/mapped_file.hpp"
+
+#include "rose/common.hpp"
+
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rose {
+
+#ifdef _WIN32
+
+  MappedFile::~MappedFile() {
+    if (m_data)
+      UnmapViewOfFile(m_data);
+    if (m_mapping)
+      CloseHandle(m_mapping);
+  }
+
+  auto MappedFile::open(const std::string& path) -> std::unique_ptr<MappedFile> {
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return nullptr;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+      CloseHandle(file);
+      return nullptr;
+    }
+
+    const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+      return nullptr;
+
+    std::unique_ptr<MappedFile> result {new MappedFile};
+    result->m_mapping = mapping;
+    result->m_data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    result->m_size = static_cast<usize>(size.QuadPart);
+    if (!result->m_data)
+      return nullptr;
+    return result;
+  }
+
+#else
+
+  MappedFile::~MappedFile() {
+    if (m_data)
+      munmap(const_cast<std::byte*>(m_data), m_size);
+  }
+
+  auto MappedFile::open(const std::string& path) -> std::unique_ptr<MappedFile> {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+      close(fd);
+      return nullptr;
+    }
+
+    void* data = mmap(nullptr, static_cast<usize>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+      return nullptr;
+
+    std::unique_ptr<MappedFile> result {new MappedFile};
+    result->m_data = static_cast<const std::byte*>(data);
+    result->m_size = static_cast<usize>(st.st_size);
+    return result;
+  }
+
+#endif
+
+}  // namespace rose
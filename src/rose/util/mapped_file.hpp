@@ -0,0 +1,35 @@
+#pragma once
+
+#include "rose/common.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace rose {
+
+  // Read-only memory mapping of a whole file. Pages are shared with every other process mapping the same file.
+  struct MappedFile {
+  private:
+    const std::byte* m_data = nullptr;
+    usize m_size = 0;
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+#endif
+
+    MappedFile() = default;
+
+  public:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    static auto open(const std::string& path) -> std::unique_ptr<MappedFile>;
+
+    auto bytes() const -> std::span<const std::byte> {
+      return {m_data, m_size};
+    }
+  };
+
+}  // namespace rose
@@ -38,7 +38,7 @@ namespace rose {
     }
 
     for (; i < str.size(); i++) {
-      if (str[i] < '0' && str[i] > '9')
+      if (str[i] < '0' || str[i] > '9')
         return std::nullopt;
       if (__builtin_mul_overflow(result, static_cast<Int>(10), &result))
         return std::nullopt;
@@ -1,5 +1,6 @@
 #include "rose/version.hpp"
 
+#include <lps/lps.hpp>
 #include <string_view>
 
 namespace rose::version {
@@ -8,4 +9,14 @@ namespace rose::version {
   const std::string_view git_commit_hash { ROSE_GIT_COMMIT_HASH };
   const std::string_view git_commit_desc { ROSE_GIT_COMMIT_DESC };
 
+#if LPS_AVX512
+  const std::string_view simd_environment {"avx512"};
+#elif LPS_AVX2
+  const std::string_view simd_environment {"avx2"};
+#elif LPS_SSE4_2
+  const std::string_view simd_environment {"sse4.2"};
+#else
+  const std::string_view simd_environment {"generic"};
+#endif
+
 }  // namespace rose::version
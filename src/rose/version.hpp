@@ -8,6 +8,8 @@ namespace rose::version {
   extern const std::string_view version_string;
   extern const std::string_view git_commit_hash;
   extern const std::string_view git_commit_desc;
+  // The lps environment this copy of the engine was compiled for.
+  extern const std::string_view simd_environment;
 
   inline auto to_string() -> std::string {
     return fmt::format("{}-dev-{}", version_string, git_commit_desc.empty() ? "NOHASH" : git_commit_desc);
@@ -18,12 +18,14 @@ u64 is_legal_perft(const Position& position, usize depth) {
 
   u64 result = 0;
 
+  const PinInfo pin_info = position.calc_pin_info();
+
   for (u32 i = 0; i < 0x10000; i++) {
     if ((i & 0xF000) >= 0xA000 && (i & 0xF000) <= 0xB000)
       continue;
 
     Move m = std::bit_cast<Move>(static_cast<u16>(i));
-    if (position.is_legal(m)) {
+    if (position.is_legal(m, pin_info)) {
       Position child_position = position.move(m);
       u64 child = is_legal_perft<false>(child_position, depth - 1);
       result += child;
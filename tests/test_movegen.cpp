@@ -1,6 +1,7 @@
 #include "rose/movegen.hpp"
 #include "rose/position.hpp"
 #include "rose/util/assert.hpp"
+#include "walk.hpp"
 
 #include <fmt/format.h>
 #include <string_view>
@@ -44,7 +45,19 @@ auto double_check() -> void {
   }
 }
 
+auto checkCount(const Position& position) -> void {
+  rose_assert(count_legal_moves(position) == generate_all_moves(position).size(), "{}: move count mismatch", position.to_string(MoveFormat::frc));
+}
+
+auto count_matches_list() -> void {
+  for (const std::string_view fen : test::walk_fens) {
+    fmt::print("{}\n", fen);
+    test::walk(Position::parse(fen).value(), 3, checkCount);
+  }
+}
+
 auto main() -> int {
   double_check();
+  count_matches_list();
   return 0;
 }
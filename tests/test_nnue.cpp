@@ -0,0 +1,328 @@
+#include "rose/common.hpp"
+#include "rose/eval/nnue/arch.hpp"
+#include "rose/eval/nnue/batch.hpp"
+#include "rose/eval/nnue/network.hpp"
+#include "rose/movegen.hpp"
+#include "rose/position.hpp"
+#include "rose/util/assert.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fmt/format.h>
+#include <memory>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+using namespace rose;
+using namespace rose::eval::nnue;
+
+template<typename T, usize N>
+auto randomise(std::mt19937_64& prng, std::array<T, N>& values, int lo, int hi) -> void {
+  std::uniform_int_distribution<int> dist {lo, hi};
+  for (T& value : values)
+    value = static_cast<T>(dist(prng));
+}
+
+// Weights are kept small enough that no intermediate value can overflow, so any two correct implementations agree exactly.
+template<typename Arch>
+auto random_kyanite_network(std::mt19937_64& prng) -> std::unique_ptr<typename Arch::Network> {
+  auto net = std::make_unique<typename Arch::Network>();
+  for (auto& row : net->accumulator_weights)
+    randomise(prng, row, -48, 48);
+  randomise(prng, net->accumulator_biases, -64, 192);
+  for (auto& bucket : net->output_weights)
+    for (auto& row : bucket)
+      randomise(prng, row, -8, 8);
+  randomise(prng, net->output_bias, -1000, 1000);
+  return net;
+}
+
+// Output weights are bounded so that the summed output cannot overflow an i32 even in the worst case.
+template<typename Arch>
+auto random_jasper_network(std::mt19937_64& prng) -> std::unique_ptr<typename Arch::Network> {
+  auto net = std::make_unique<typename Arch::Network>();
+  for (auto& row : net->accumulator_weights)
+    randomise(prng, row, -48, 48);
+  randomise(prng, net->accumulator_biases, -64, 192);
+  for (auto& row : net->output_weights)
+    randomise(prng, row, -32, 32);
+  net->output_bias = static_cast<i16>(std::uniform_int_distribution<int> {-1000, 1000}(prng));
+  return net;
+}
+
+template<typename Arch>
+using ReferenceAccumulators = std::array<std::array<i32, Arch::hidden_size>, 2>;
+
+// Feature transformer output for both perspectives, straight from the file layout.
+template<typename Arch>
+auto reference_accumulators(const typename Arch::Network& net, const Position& pos) -> ReferenceAccumulators<Arch> {
+  ReferenceAccumulators<Arch> acc;
+  for (auto& a : acc)
+    std::ranges::copy(net.accumulator_biases, a.begin());
+
+  for (u8 i = 0; i < 64; i++) {
+    const Square sq {i};
+    const Place p = pos.place_at(sq);
+    if (p.is_empty())
+      continue;
+    for (const Color perspective : {Color::white, Color::black}) {
+      const usize feature = Arch::feature_index(pos, perspective, sq, p.ptype(), p.color());
+      for (usize j = 0; j < Arch::hidden_size; j++)
+        acc[perspective.to_index()][j] += net.accumulator_weights[feature][j];
+    }
+  }
+  return acc;
+}
+
+// Straightforward scalar evaluation straight from the file layout.
+template<typename Arch>
+auto reference_kyanite(const typename Arch::Network& net, const Position& pos) -> i32 {
+  const ReferenceAccumulators<Arch> acc = reference_accumulators<Arch>(net, pos);
+  const usize piece_count = static_cast<usize>(pos.board().occupied_bitboard().popcount());
+
+  const auto screlu = [](i32 x) -> i64 {
+    const i64 y = std::clamp<i32>(x, 0, Arch::qa);
+    return y * y;
+  };
+
+  const usize bucket_count = net.output_bias.size();
+  const usize bucket = (piece_count - 2) / ((32 + bucket_count - 1) / bucket_count);
+
+  const Color stm = pos.stm();
+  i64 output = 0;
+  for (usize j = 0; j < Arch::hidden_size; j++) {
+    output += screlu(acc[stm.to_index()][j]) * net.output_weights[bucket][0][j];
+    output += screlu(acc[stm.invert().to_index()][j]) * net.output_weights[bucket][1][j];
+  }
+  output /= Arch::qa;
+  output += net.output_bias[bucket];
+  output *= Arch::scale;
+  output /= Arch::qa * Arch::qb;
+  return static_cast<i32>(output);
+}
+
+// The scalar evaluation Jasper used before it was vectorised.
+template<typename Arch>
+auto reference_jasper(const typename Arch::Network& net, const Position& pos) -> i32 {
+  const ReferenceAccumulators<Arch> acc = reference_accumulators<Arch>(net, pos);
+
+  const auto screlu = [](i32 x) -> i32 {
+    const i32 y = std::clamp<i32>(x, 0, Arch::qa);
+    return y * y;
+  };
+
+  const Color stm = pos.stm();
+  i32 output = 0;
+  for (usize i = 0; i < Arch::hidden_size; i++) {
+    output += screlu(acc[stm.to_index()][i]) * net.output_weights[0][i];
+    output += screlu(acc[stm.invert().to_index()][i]) * net.output_weights[1][i];
+  }
+  output /= Arch::qa;
+  output += net.output_bias;
+  output *= Arch::scale;
+  output /= Arch::qa * Arch::qb;
+  return output;
+}
+
+const std::vector<std::string_view> start_fens {{
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+  "2r1kr2/8/8/8/8/8/8/1R2K1R1 w GBfc - 0 1",
+  "8/8/4k3/3p4/3K4/4P3/8/8 w - - 0 1",
+}};
+
+template<typename Arch>
+auto random_garnet_network(std::mt19937_64& prng) -> std::unique_ptr<typename Arch::Network> {
+  auto net = std::make_unique<typename Arch::Network>();
+  for (auto& row : net->accumulator_weights)
+    randomise(prng, row, -48, 48);
+  randomise(prng, net->accumulator_biases, -160, 96);
+  for (auto& row : net->l1_weights)
+    randomise(prng, row, -128, 127);
+  randomise(prng, net->l1_biases, -8192, 8192);
+  for (auto& row : net->l2_weights)
+    randomise(prng, row, -128, 127);
+  randomise(prng, net->l2_biases, -8192, 8192);
+  randomise(prng, net->l3_weights, -128, 127);
+  net->l3_bias = std::uniform_int_distribution<i32> {-8192, 8192}(prng);
+  return net;
+}
+
+// Dense first layer straight from the file layout.
+template<typename Arch>
+auto reference_garnet_l1(const typename Arch::Network& net, std::span<const i32> activations) -> std::array<i32, Arch::l1_output_size> {
+  std::array<i32, Arch::l1_output_size> output = net.l1_biases;
+  for (usize i = 0; i < Arch::l1_input_size; i++)
+    for (usize j = 0; j < Arch::l1_output_size; j++)
+      output[j] += activations[i] * net.l1_weights[i][j];
+  return output;
+}
+
+template<typename Arch>
+auto reference_garnet(const typename Arch::Network& net, const Position& pos) -> i32 {
+  const ReferenceAccumulators<Arch> acc = reference_accumulators<Arch>(net, pos);
+  const Color stm = pos.stm();
+
+  std::vector<i32> inputs;
+  for (const Color perspective : {stm, stm.invert()})
+    for (const i32 x : acc[perspective.to_index()])
+      inputs.push_back(std::clamp(x, 0, Arch::qa));
+
+  const auto crelu = [](i32 x) -> i32 {
+    return std::clamp(x / Arch::qb, 0, Arch::qa);
+  };
+
+  const std::array<i32, Arch::l1_output_size> l1_output = reference_garnet_l1<Arch>(net, inputs);
+
+  std::array<i32, Arch::l2_output_size> l2_output = net.l2_biases;
+  for (usize j = 0; j < Arch::l1_output_size; j++)
+    for (usize k = 0; k < Arch::l2_output_size; k++)
+      l2_output[k] += crelu(l1_output[j]) * net.l2_weights[j][k];
+
+  i64 output = net.l3_bias;
+  for (usize k = 0; k < Arch::l2_output_size; k++)
+    output += crelu(l2_output[k]) * net.l3_weights[k];
+
+  return static_cast<i32>(output * Arch::scale / (Arch::qa * Arch::qb));
+}
+
+// Compares the sparse first layer against the dense reference across a range of activation densities.
+template<typename Arch>
+auto garnet_sparse_l1(std::mt19937_64& prng, const typename Arch::Network& net) -> void {
+  const auto layers = std::make_unique<typename Arch::Layers>(Arch::Layers::from_network(net));
+
+  for (const double density : {0.0, 0.01, 0.1, 0.5, 1.0}) {
+    std::bernoulli_distribution nonzero {density};
+    std::uniform_int_distribution<int> value {1, Arch::qa};
+
+    alignas(64) typename Arch::Activations activations {};
+    std::vector<i32> inputs(Arch::l1_input_size);
+    for (usize i = 0; i < Arch::l1_input_size; i++) {
+      inputs[i] = nonzero(prng) ? value(prng) : 0;
+      activations[i] = static_cast<u8>(inputs[i]);
+    }
+
+    alignas(64) typename Arch::NonZeroChunks nnz;
+    const usize nnz_count = Arch::find_nonzero_chunks(activations, nnz);
+    usize expected_count = 0;
+    for (usize chunk = 0; chunk < Arch::chunk_count; chunk++) {
+      if (std::ranges::any_of(std::span {inputs}.subspan(chunk * Arch::chunk_size, Arch::chunk_size), [](i32 x) { return x != 0; })) {
+        rose_assert(expected_count < nnz_count && nnz[expected_count] == chunk);
+        expected_count++;
+      }
+    }
+    rose_assert(expected_count == nnz_count);
+
+    rose_assert(Arch::l1_forward(*layers, activations) == reference_garnet_l1<Arch>(net, inputs));
+  }
+}
+
+// Plays random games, updating the state incrementally, and compares every evaluation against the reference.
+template<typename Arch, typename Reference>
+auto random_games(std::mt19937_64& prng, const typename Arch::Network& net, Reference reference) -> void {
+  typename Arch::State state {net};
+
+  for (const std::string_view fen : start_fens) {
+    Position pos = Position::parse(fen).value();
+    state.reset(pos);
+
+    for (int ply = 0; ply < 160; ply++) {
+      const i32 expected = reference(net, pos);
+      const i32 actual = state.evaluate(pos);
+      rose_assert(expected == actual, "{}: {} != {}", pos.to_string(MoveFormat::frc), expected, actual);
+
+      const MoveList moves = generate_all_moves(pos);
+      if (moves.size() == 0)
+        break;
+      const Move m = moves[std::uniform_int_distribution<usize> {0, moves.size() - 1}(prng)];
+
+      state.push();
+      pos = pos.move(m, state.observer());
+    }
+  }
+}
+
+auto kyanite_king_buckets() -> void {
+  using Arch = Kyanite768kb4;
+  const auto sq = [](std::string_view str) { return Square::parse(str).value(); };
+
+  rose_assert(Arch::king_bucket(sq("a1"), Color::white) == 0);
+  rose_assert(Arch::king_bucket(sq("h1"), Color::white) == 0);
+  rose_assert(Arch::king_bucket(sq("e1"), Color::white) == 1);
+  rose_assert(Arch::king_bucket(sq("e8"), Color::black) == 1);
+  rose_assert(Arch::king_bucket(sq("b7"), Color::black) == 2);
+  rose_assert(Arch::king_bucket(sq("b7"), Color::white) == 3);
+  rose_assert(Arch::king_bucket(sq("d5"), Color::white) == 3);
+
+  rose_assert(Arch::refresh_key(sq("d1"), Color::white) != Arch::refresh_key(sq("e1"), Color::white));
+  rose_assert(Arch::refresh_key(sq("a2"), Color::white) == Arch::refresh_key(sq("d2"), Color::white));
+}
+
+template<typename Arch>
+auto jasper_exactness() -> void {
+  std::mt19937_64 prng {87};
+  const auto net = random_jasper_network<Arch>(prng);
+  random_games<Arch>(prng, *net, reference_jasper<Arch>);
+}
+
+template<typename Arch>
+auto kyanite_exactness() -> void {
+  std::mt19937_64 prng {87};
+  const auto net = random_kyanite_network<Arch>(prng);
+  random_games<Arch>(prng, *net, reference_kyanite<Arch>);
+}
+
+template<typename Arch>
+auto garnet_exactness() -> void {
+  std::mt19937_64 prng {87};
+  const auto net = random_garnet_network<Arch>(prng);
+  garnet_sparse_l1<Arch>(prng, *net);
+  random_games<Arch>(prng, *net, reference_garnet<Arch>);
+}
+
+// Batch evaluation over several threads must agree with evaluating each position on its own.
+auto batch_evaluation() -> void {
+  std::mt19937_64 prng {87};
+
+  std::vector<Position> positions;
+  for (const std::string_view fen : start_fens) {
+    Position pos = Position::parse(fen).value();
+    for (int ply = 0; ply < 41; ply++) {
+      positions.push_back(pos);
+      const MoveList moves = generate_all_moves(pos);
+      if (moves.size() == 0)
+        break;
+      pos = pos.move(moves[std::uniform_int_distribution<usize> {0, moves.size() - 1}(prng)]);
+    }
+  }
+
+  const LoadedNetwork network = LoadedNetwork::embedded();
+  std::vector<Score> scores(positions.size());
+  evaluate_batch(network, positions, scores, 3);
+
+  network.visit([&]<typename Arch>(const Arch::Network& net) {
+    const auto state = std::make_unique<typename Arch::State>(net);
+    for (usize i = 0; i < positions.size(); i++) {
+      state->reset(positions[i]);
+      rose_assert(state->evaluate(positions[i]) == scores[i]);
+    }
+  });
+}
+
+auto main() -> int {
+  jasper_exactness<Jasper<128>>();
+  jasper_exactness<Jasper<256>>();
+  kyanite_exactness<Kyanite<256>>();
+  kyanite_exactness<Kyanite<768>>();
+  kyanite_exactness<Kyanite<768, i8>>();
+  kyanite_exactness<Kyanite<768, i16, 8>>();
+  kyanite_king_buckets();
+  kyanite_exactness<Kyanite768kb4>();
+  garnet_exactness<Garnet768>();
+  batch_evaluation();
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include "rose/common.hpp"
+#include "rose/eval/nnue/arch.hpp"
+#include "rose/eval/nnue/container.hpp"
+#include "rose/eval/nnue/network.hpp"
+#include "rose/util/assert.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <fmt/format.h>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace rose;
+using namespace rose::eval::nnue;
+
+template<typename Arch>
+auto make_container(usize payload_size) -> std::vector<std::byte> {
+  std::mt19937_64 prng {87};
+  std::vector<std::byte> payload(payload_size);
+  for (std::byte& b : payload)
+    b = static_cast<std::byte>(prng());
+
+  const container::Header header = container::make_header<Arch>(payload);
+  std::vector<std::byte> result(sizeof(header));
+  std::memcpy(result.data(), &header, sizeof(header));
+  result.insert(result.end(), payload.begin(), payload.end());
+  return result;
+}
+
+auto expect_error(std::span<const std::byte> bytes, NetworkError expected) -> void {
+  const auto parsed = container::parse(bytes);
+  rose_assert(!parsed && parsed.error() == expected, "expected {}", expected);
+}
+
+auto round_trip() -> void {
+  using Arch = Kyanite<256>;
+  constexpr usize exact = sizeof(Arch::Network);
+  constexpr usize padded = (exact + 63) / 64 * 64;
+
+  for (const usize size : {exact, padded}) {
+    const auto bytes = make_container<Arch>(size);
+    const auto parsed = container::parse(bytes);
+    rose_assert(parsed.has_value());
+    const auto [arch, payload] = *parsed;
+    rose_assert(arch == ArchId::kyanite256);
+    rose_assert(payload.data() == bytes.data() + sizeof(container::Header));
+    rose_assert(payload.size() == size);
+  }
+}
+
+auto rejects_corruption() -> void {
+  using Arch = Jasper<128>;
+  const auto good = make_container<Arch>(sizeof(Arch::Network));
+
+  expect_error(std::span {good}.first(10), NetworkError::too_small);
+
+  auto bad_magic = good;
+  bad_magic[0] = std::byte {'X'};
+  expect_error(bad_magic, NetworkError::bad_magic);
+
+  auto flipped = good;
+  flipped[sizeof(container::Header) + 1234] ^= std::byte {0x10};
+  expect_error(flipped, NetworkError::checksum_mismatch);
+
+  auto truncated = good;
+  truncated.pop_back();
+  expect_error(truncated, NetworkError::payload_size_mismatch);
+
+  container::Header header;
+  std::memcpy(&header, good.data(), sizeof(header));
+
+  auto wrong_arch = good;
+  header.arch = {{'j', 'a', 's', 'p', 'e', 'r', '9', '9', '9'}};
+  std::memcpy(wrong_arch.data(), &header, sizeof(header));
+  expect_error(wrong_arch, NetworkError::unknown_arch);
+
+  // A jasper128 payload relabelled as jasper256 has the wrong size.
+  auto relabelled = good;
+  std::memcpy(&header, good.data(), sizeof(header));
+  header.arch = {{'j', 'a', 's', 'p', 'e', 'r', '2', '5', '6'}};
+  header.hidden_size = 256;
+  std::memcpy(relabelled.data(), &header, sizeof(header));
+  expect_error(relabelled, NetworkError::payload_size_mismatch);
+
+  auto wrong_hidden = good;
+  std::memcpy(&header, good.data(), sizeof(header));
+  header.hidden_size = 256;
+  std::memcpy(wrong_hidden.data(), &header, sizeof(header));
+  expect_error(wrong_hidden, NetworkError::hidden_size_mismatch);
+
+  auto wrong_quantisation = good;
+  std::memcpy(&header, good.data(), sizeof(header));
+  header.qa = 127;
+  std::memcpy(wrong_quantisation.data(), &header, sizeof(header));
+  expect_error(wrong_quantisation, NetworkError::quantisation_mismatch);
+
+  auto wrong_weight_type = good;
+  std::memcpy(&header, good.data(), sizeof(header));
+  header.ft_weight_bits = 8;
+  std::memcpy(wrong_weight_type.data(), &header, sizeof(header));
+  expect_error(wrong_weight_type, NetworkError::quantisation_mismatch);
+}
+
+// Containers written before ft_weight_bits existed have version 1 and zero in its place; they hold i16 weights.
+auto version1() -> void {
+  const auto make_version1 = []<typename Arch>() {
+    auto bytes = make_container<Arch>(sizeof(typename Arch::Network));
+    container::Header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    header.version = 1;
+    header.ft_weight_bits = 0;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    return bytes;
+  };
+
+  rose_assert(container::parse(make_version1.operator()<Kyanite<256>>()).has_value());
+  expect_error(make_version1.operator()<Kyanite768i8>(), NetworkError::quantisation_mismatch);
+
+  auto future = make_container<Kyanite<256>>(sizeof(Kyanite<256>::Network));
+  container::Header header;
+  std::memcpy(&header, future.data(), sizeof(header));
+  header.version = container::current_version + 1;
+  std::memcpy(future.data(), &header, sizeof(header));
+  expect_error(future, NetworkError::unsupported_version);
+}
+
+auto embedded() -> void {
+  // Must not exit; the embedded network is verified on first use.
+  const LoadedNetwork network = LoadedNetwork::embedded();
+  rose_assert(network.is_embedded());
+}
+
+auto main() -> int {
+  round_trip();
+  rejects_corruption();
+  version1();
+  embedded();
+  return 0;
+}
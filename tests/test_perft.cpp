@@ -54,6 +54,13 @@ auto main() -> int {
       fmt::print("{}: {} ({})\n", depth, value, results[depth]);
       rose_assert(value == results[depth]);
     }
+
+    // A small table forces replacements and two threads share it.
+    for (usize depth = 0; depth + 1 < results.size(); depth++) {
+      const u64 value = perft::value(position, depth, {.threads = 2, .hash_mb = 1});
+      fmt::print("{} (threads 2 hash 1): {} ({})\n", depth, value, results[depth]);
+      rose_assert(value == results[depth]);
+    }
   }
 
   return 0;
@@ -1,7 +1,10 @@
 #include "rose/position.hpp"
 #include "rose/util/assert.hpp"
+#include "walk.hpp"
 
+#include <array>
 #include <fmt/format.h>
+#include <span>
 #include <string_view>
 #include <tuple>
 #include <vector>
@@ -58,9 +61,129 @@ auto frcIndex() -> void {
   }
 }
 
+// Attack tables computed by walking each piece's moves square by square, independently of the geometry kernels.
+auto referenceAttacks(const Position& position) -> std::array<std::array<PieceMask, 64>, 2> {
+  std::array<std::array<PieceMask, 64>, 2> result {};
+
+  for (u8 i = 0; i < 64; i++) {
+    const Square sq {i};
+    const Place place = position.place_at(sq);
+    if (place.is_empty())
+      continue;
+
+    std::array<PieceMask, 64>& table = result[place.color().to_index()];
+    const auto attack = [&](int df, int dr, bool slide) {
+      for (int file = sq.file() + df, rank = sq.rank() + dr; file >= 0 && file < 8 && rank >= 0 && rank < 8; file += df, rank += dr) {
+        const Square target = Square::from_file_and_rank(static_cast<i8>(file), static_cast<i8>(rank));
+        table[target.raw].raw |= place.id().to_piece_mask().raw;
+        if (!slide || !position.place_at(target).is_empty())
+          break;
+      }
+    };
+
+    constexpr std::array<std::array<int, 2>, 4> orth {{{0, 1}, {1, 0}, {0, -1}, {-1, 0}}};
+    constexpr std::array<std::array<int, 2>, 4> diag {{{1, 1}, {1, -1}, {-1, -1}, {-1, 1}}};
+    constexpr std::array<std::array<int, 2>, 8> horse {{{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}}};
+    const auto attack_all = [&](std::span<const std::array<int, 2>> dirs, bool slide) {
+      for (const auto [df, dr] : dirs)
+        attack(df, dr, slide);
+    };
+
+    switch (place.ptype().raw) {
+    case PieceType::p:
+      attack(-1, place.color() == Color::white ? 1 : -1, false);
+      attack(1, place.color() == Color::white ? 1 : -1, false);
+      break;
+    case PieceType::n:
+      attack_all(horse, false);
+      break;
+    case PieceType::b:
+      attack_all(diag, true);
+      break;
+    case PieceType::r:
+      attack_all(orth, true);
+      break;
+    case PieceType::q:
+      attack_all(orth, true);
+      attack_all(diag, true);
+      break;
+    case PieceType::k:
+      attack_all(orth, false);
+      attack_all(diag, false);
+      break;
+    default:
+      rose_assert(false);
+    }
+  }
+
+  return result;
+}
+
+auto checkAttacks(const Position& position) -> void {
+  const auto expected = referenceAttacks(position);
+  for (u8 i = 0; i < 64; i++) {
+    const Square sq {i};
+    for (const Color color : {Color::white, Color::black}) {
+      const PieceMask actual = position.attack_table(color).read(sq);
+      rose_assert(actual.raw == expected[color.to_index()][i].raw, "{}: attack table mismatch", position.to_string(MoveFormat::frc));
+    }
+  }
+}
+
+// The attack tables are updated incrementally by the byteboard kernels; check them against a reference at every node of
+// a perft tree.
+auto incrementalAttacks() -> void {
+  for (std::string_view fen : test::walk_fens) {
+    test::walk(Position::parse(fen).value(), 3, checkAttacks);
+  }
+}
+
+auto checkHashes(const Position& position, Move m, const Position& new_position) -> void {
+  const Hashes hashes = position.calc_hashes_slow();
+  Hashes new_hashes = hashes;
+  position.move(m, new_hashes);
+  rose_assert(new_hashes == position.hashes_after(hashes, m));
+  rose_assert(new_hashes == new_position.calc_hashes_slow(), "{}: hash mismatch after {}", position.to_string(MoveFormat::frc),
+              m.to_string(MoveFormat::frc));
+}
+
+// Position::move can update the hashes in the same pass; they must match both hashes_after and a full recalculation.
+auto fusedHashes() -> void {
+  for (std::string_view fen : test::walk_fens) {
+    test::walk_moves(Position::parse(fen).value(), 3, checkHashes);
+  }
+}
+
+auto checkGivesCheck(const Position& position, Move m, const Position& new_position) -> void {
+  rose_assert(position.gives_check(m) == new_position.is_in_check(), "{}: gives_check mismatch for {}", position.to_string(MoveFormat::frc),
+              m.to_string(MoveFormat::frc));
+}
+
+// Checks from castling rooks, discovered checks, and checks uncovered by removing an en passant victim.
+const std::vector<std::string_view> check_fens {{
+  "5k2/8/8/8/8/8/8/4K2R w K - 0 1",
+  "2k5/8/8/8/8/8/8/R3K3 w Q - 0 1",
+  "4k3/8/4N3/8/1B6/8/4R3/4K3 w - - 0 1",
+  "8/8/8/R2pP2k/8/8/8/K7 w - d6 0 1",
+  "6k1/8/8/2Pp4/8/8/B7/K7 w - d6 0 1",
+}};
+
+// gives_check must agree with making the move for every move of a perft tree.
+auto givesCheck() -> void {
+  for (std::string_view fen : test::walk_fens) {
+    test::walk_moves(Position::parse(fen).value(), 3, checkGivesCheck);
+  }
+  for (std::string_view fen : check_fens) {
+    test::walk_moves(Position::parse(fen).value(), 4, checkGivesCheck);
+  }
+}
+
 auto main() -> int {
   roundtripClassical();
   roundtripDfrc();
   frcIndex();
+  incrementalAttacks();
+  fusedHashes();
+  givesCheck();
   return 0;
 }
@@ -0,0 +1,43 @@
+#include "rose/movegen.hpp"
+#include "rose/position.hpp"
+#include "rose/see.hpp"
+#include "rose/util/assert.hpp"
+#include "walk.hpp"
+
+#include <array>
+#include <fmt/format.h>
+#include <string_view>
+
+using namespace rose;
+
+// Thresholds on either side of the balances reachable after the first one or two captures.
+constexpr std::array<Score, 22> thresholds {{
+  -10001, -1200, -900, -700, -601, -600, -599, -401, -400, -399, -300, -201, -200, -199, -101, -100, -99, -17, -1, 0, 1, 100,
+}};
+
+// Each node gets its own cache and safety map, as in MovePicker.
+auto checkSee(const Position& position) -> void {
+  see::ExchangeCache exchanges;
+  see::SafetyMap safety;
+  for (const Move m : generate_all_moves(position)) {
+    for (const Score threshold : thresholds) {
+      const bool expected = see::see(position, m, threshold);
+      const bool got = m.is_noisy() ? exchanges.see(position, m, threshold) : safety.see(position, m, threshold);
+      rose_assert(got == expected, "{}: see mismatch for {} at threshold {}", position.to_string(MoveFormat::frc), m.to_string(MoveFormat::frc),
+                  threshold);
+    }
+  }
+}
+
+// The exchange cache and the safety map are shortcuts; they must agree with see::see for every move of a perft tree.
+// A depth 2 walk checks the moves of every node above the leaves of a depth 3 tree.
+auto sharedSee() -> void {
+  for (std::string_view fen : test::walk_fens) {
+    test::walk(Position::parse(fen).value(), 2, checkSee);
+  }
+}
+
+auto main() -> int {
+  sharedSee();
+  return 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "rose/common.hpp"
+#include "rose/movegen.hpp"
+#include "rose/position.hpp"
+
+#include <string_view>
+#include <vector>
+
+namespace rose::test {
+
+  // Start positions for tests that check an invariant over a perft tree. Covers captures, promotions, en passant, double
+  // check and (chess960) castling.
+  inline const std::vector<std::string_view> walk_fens {{
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "1bbrnkqr/pp1p1ppp/2p1p3/1n6/5P2/3Q4/PPPPP1PP/NBBRNK1R w HDhd - 2 9",
+    "2r1kr2/8/8/8/8/8/8/1R2K1R1 w GBfc - 0 1",
+    "3q3k/6b1/8/8/3K4/2P1P3/8/8 w - - 0 1",
+  }};
+
+  // Calls visit(position) at every node of the perft tree of the given depth, leaves included.
+  template<typename F>
+  auto walk(const Position& position, usize depth, F&& visit) -> void {
+    visit(position);
+    if (depth == 0)
+      return;
+    for (const Move m : generate_all_moves(position))
+      walk(position.move(m), depth - 1, visit);
+  }
+
+  // Calls visit(position, m, position.move(m)) for every move m of the perft tree of the given depth.
+  template<typename F>
+  auto walk_moves(const Position& position, usize depth, F&& visit) -> void {
+    if (depth == 0)
+      return;
+    for (const Move m : generate_all_moves(position)) {
+      const Position new_position = position.move(m);
+      visit(position, m, new_position);
+      walk_moves(new_position, depth - 1, visit);
+    }
+  }
+
+}  // namespace rose::test
@@ -0,0 +1,20 @@
+#include "rose/common.hpp"
+#include "rose/tool/evalbatch/evalbatch.hpp"
+#include "rose/util/string.hpp"
+
+#include <fmt/format.h>
+
+auto main(int argc, char** argv) -> int {
+  if (argc != 5) {
+    fmt::print("Usage: {} <network|<embedded>> <thread count> <input> <output>\n", argv[0]);
+    return 1;
+  }
+
+  const auto thread_count = rose::parse_usize(argv[2]);
+  if (!thread_count || *thread_count == 0) {
+    fmt::print("Invalid thread count\n");
+    return 1;
+  }
+
+  return rose::tool::evalbatch::run(argv[1], argv[3], argv[4], *thread_count) ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+#include "rose/common.hpp"
+#include "rose/tool/netwrap/netwrap.hpp"
+
+#include <fmt/format.h>
+
+auto main(int argc, char** argv) -> int {
+  if (argc != 4) {
+    fmt::print("Usage: {} <arch|auto> <input> <output>\n", argv[0]);
+    return 1;
+  }
+
+  return rose::tool::netwrap::run(argv[1], argv[2], argv[3]) ? 0 : 1;
+}